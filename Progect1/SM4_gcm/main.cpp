@@ -237,6 +237,488 @@ void test_long_message() {
     printf("\n");
 }
 
+// 5: ֶʽһԴͬ
+void test_streaming() {
+    printf("=== Test 5: Streaming (chunked) ===\n");
+
+    uint8_t key[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    uint8_t iv[12] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98
+    };
+
+    uint8_t aad[37];
+    uint8_t plaintext[1000], ciphertext[1000], streamed[1000], forked[1000];
+    for (size_t i = 0; i < sizeof(aad); i++) aad[i] = (uint8_t)(i * 7);
+    for (size_t i = 0; i < sizeof(plaintext); i++) plaintext[i] = (uint8_t)(i * 13 + 5);
+
+    uint8_t tag[16], stream_tag[16], fork_tag[16];
+    sm4_gcm_encrypt(key, iv, sizeof(iv), aad, sizeof(aad),
+        plaintext, sizeof(plaintext), ciphertext, tag, sizeof(tag));
+
+    // AADĶ򳤶ȷֶ
+    static const size_t chunks[] = { 1, 15, 3, 16, 33, 7, 100, 250 };
+    sm4_gcm_keyed_ctx s;
+    sm4_gcm_init(&s, key, iv, sizeof(iv));
+    sm4_gcm_ctx* ctx = &s.ctx;
+    size_t off = 0;
+    for (int i = 0; off < sizeof(aad); i++) {
+        size_t n = chunks[i % 8] < sizeof(aad) - off ? chunks[i % 8] : sizeof(aad) - off;
+        sm4_gcm_aad(ctx, aad + off, n);
+        off += n;
+    }
+    // ֵͣAAD֮һݣ֮ݸԶ
+    sm4_gcm_ctx fork = *ctx;
+    off = 0;
+    for (int i = 0; off < sizeof(plaintext); i++) {
+        size_t n = chunks[i % 8] < sizeof(plaintext) - off ? chunks[i % 8] : sizeof(plaintext) - off;
+        sm4_gcm_crypt(ctx, plaintext + off, streamed + off, n);
+        off += n;
+    }
+    sm4_gcm_tag(ctx, stream_tag, sizeof(stream_tag));
+
+    if (memcmp(ciphertext, streamed, sizeof(ciphertext)) == 0 && memcmp(tag, stream_tag, 16) == 0) {
+        printf("Success: chunked output matches one-shot\n");
+    }
+    else {
+        printf("ERROR: chunked output differs from one-shot\n");
+    }
+
+    sm4_gcm_crypt(&fork, plaintext, forked, sizeof(plaintext));
+    sm4_gcm_tag(&fork, fork_tag, sizeof(fork_tag));
+    if (memcmp(ciphertext, forked, sizeof(ciphertext)) == 0 && memcmp(tag, fork_tag, 16) == 0) {
+        printf("Success: copied context matches one-shot\n");
+    }
+    else {
+        printf("ERROR: copied context differs from one-shot\n");
+    }
+
+    printf("\n");
+}
+
+// 6: ԿֻչһΣnonceܶϢ
+void test_key_reuse() {
+    printf("=== Test 6: Key Reuse (seal/open) ===\n");
+
+    uint8_t key[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    sm4_gcm_key gcm_key;
+    sm4_gcm_key_init(&gcm_key, key);
+
+    uint8_t aad[13] = { 0x17, 0x03, 0x03 };
+    uint8_t record[300], sealed[300], expected[300], opened[300];
+    uint8_t tag[16], expected_tag[16];
+    int ok = 1;
+
+    for (uint32_t seq = 0; seq < 64; seq++) {
+        // ÿ¼ʹòͬnonceͳ
+        uint8_t nonce[12] = { 0 };
+        nonce[8] = (uint8_t)(seq >> 24);
+        nonce[9] = (uint8_t)(seq >> 16);
+        nonce[10] = (uint8_t)(seq >> 8);
+        nonce[11] = (uint8_t)seq;
+        size_t len = (seq * 37) % sizeof(record);
+        for (size_t i = 0; i < len; i++) record[i] = (uint8_t)(i + seq);
+
+        sm4_gcm_seal(&gcm_key, nonce, sizeof(nonce), aad, sizeof(aad), record, len, sealed, tag, sizeof(tag));
+        sm4_gcm_encrypt(key, nonce, sizeof(nonce), aad, sizeof(aad), record, len, expected, expected_tag, sizeof(expected_tag));
+        if (memcmp(sealed, expected, len) != 0 || memcmp(tag, expected_tag, 16) != 0) {
+            ok = 0;
+        }
+        if (sm4_gcm_open(&gcm_key, nonce, sizeof(nonce), aad, sizeof(aad), sealed, len, tag, sizeof(tag), opened) != 0 ||
+            memcmp(opened, record, len) != 0) {
+            ok = 0;
+        }
+    }
+
+    if (ok) {
+        printf("Success: 64 records sealed/opened with one expanded key\n");
+    }
+    else {
+        printf("ERROR: seal/open differs from sm4_gcm_encrypt\n");
+    }
+
+    printf("\n");
+}
+
+// 7: Ϣ
+void test_batch() {
+    printf("=== Test 7: Multi-buffer Batch ===\n");
+
+    uint8_t key[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    sm4_gcm_key gcm_key;
+    sm4_gcm_key_init(&gcm_key, key);
+
+    enum { NJOBS = 32, MAXLEN = 200 };
+    static uint8_t nonce[NJOBS][12], packet[NJOBS][MAXLEN], sealed[NJOBS][MAXLEN], opened[NJOBS][MAXLEN];
+    static uint8_t tag[NJOBS][16];
+    sm4_gcm_job jobs[NJOBS];
+
+    for (int i = 0; i < NJOBS; i++) {
+        memset(nonce[i], 0, 12);
+        nonce[i][11] = (uint8_t)i;
+        size_t len = (size_t)(i * 29) % MAXLEN;
+        for (size_t j = 0; j < len; j++) packet[i][j] = (uint8_t)(i ^ j);
+        sm4_gcm_job job = { &gcm_key, nonce[i], 12, nonce[i], 12, packet[i], sealed[i], len, tag[i], 16, 0 };
+        jobs[i] = job;
+    }
+    sm4_gcm_seal_batch(jobs, NJOBS);
+
+    // ܱȽ
+    int ok = 1;
+    for (int i = 0; i < NJOBS; i++) {
+        uint8_t expected[MAXLEN], expected_tag[16];
+        sm4_gcm_seal(&gcm_key, nonce[i], 12, nonce[i], 12, packet[i], jobs[i].len, expected, expected_tag, 16);
+        if (memcmp(expected, sealed[i], jobs[i].len) != 0 || memcmp(expected_tag, tag[i], 16) != 0) {
+            ok = 0;
+        }
+        jobs[i].in = sealed[i];
+        jobs[i].out = opened[i];
+    }
+
+    // ۸ĵ5ıǩֻһӦ֤ʧ
+    tag[5][0] ^= 1;
+    int failed = sm4_gcm_open_batch(jobs, NJOBS);
+    for (int i = 0; i < NJOBS; i++) {
+        if (i != 5 && memcmp(opened[i], packet[i], jobs[i].len) != 0) {
+            ok = 0;
+        }
+    }
+
+    if (ok && failed == 1 && jobs[5].status == -1) {
+        printf("Success: %d packets sealed/opened in one batch, tampered packet rejected\n", NJOBS);
+    }
+    else {
+        printf("ERROR: batch result differs from per-packet processing\n");
+    }
+
+    printf("\n");
+}
+
+// 8: ̼߳ӽ뵥߳̽ͬ
+void test_multithread() {
+    printf("=== Test 8: Multithreaded (%d threads) ===\n", sm4_get_num_threads());
+
+    uint8_t key[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    uint8_t iv[12] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98
+    };
+
+    // 4 MiBӼֽڣǲһκͲһβ
+    size_t len = (4u << 20) + 5;
+    uint8_t* plaintext = (uint8_t*)malloc(len);
+    uint8_t* ciphertext = (uint8_t*)malloc(len);
+    uint8_t* mt_cipher = (uint8_t*)malloc(len);
+    if (!plaintext || !ciphertext || !mt_cipher) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+    for (size_t i = 0; i < len; i++) plaintext[i] = (uint8_t)(i * 31);
+
+    sm4_gcm_key gcm_key;
+    sm4_gcm_key_init(&gcm_key, key);
+    uint8_t tag[16], mt_tag[16];
+    sm4_gcm_seal(&gcm_key, iv, sizeof(iv), NULL, 0, plaintext, len, ciphertext, tag, sizeof(tag));
+
+    sm4_gcm_ctx ctx;
+    sm4_gcm_start(&ctx, &gcm_key, iv, sizeof(iv));
+    sm4_gcm_crypt_mt(&ctx, plaintext, mt_cipher, len);
+    sm4_gcm_tag(&ctx, mt_tag, sizeof(mt_tag));
+    int ok = memcmp(ciphertext, mt_cipher, len) == 0 && memcmp(tag, mt_tag, 16) == 0;
+
+    // ԭض߳̽
+    sm4_gcm_start(&ctx, &gcm_key, iv, sizeof(iv));
+    sm4_gcm_decrypt_update_mt(&ctx, mt_cipher, mt_cipher, len);
+    sm4_gcm_tag(&ctx, mt_tag, sizeof(mt_tag));
+    ok = ok && memcmp(plaintext, mt_cipher, len) == 0 && memcmp(tag, mt_tag, 16) == 0;
+
+    if (ok) {
+        printf("Success: multithreaded output and tag match single-threaded\n");
+    }
+    else {
+        printf("ERROR: multithreaded result differs\n");
+    }
+
+    free(plaintext);
+    free(ciphertext);
+    free(mt_cipher);
+
+    printf("\n");
+}
+
+// 9: ԭؽ֤
+void test_inplace_and_verify_first() {
+    printf("=== Test 9: In-place / Verify-first Decrypt ===\n");
+
+    uint8_t key[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    uint8_t iv[12] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98
+    };
+
+    sm4_gcm_key gcm_key;
+    sm4_gcm_key_init(&gcm_key, key);
+
+    uint8_t plaintext[777], buf[777], out[777], tag[16];
+    for (size_t i = 0; i < sizeof(plaintext); i++) plaintext[i] = (uint8_t)(i * 3);
+    sm4_gcm_seal(&gcm_key, iv, sizeof(iv), NULL, 0, plaintext, sizeof(plaintext), buf, tag, sizeof(tag));
+    memcpy(out, buf, sizeof(buf));
+
+    // һԭؽ
+    int ok = sm4_gcm_open(&gcm_key, iv, sizeof(iv), NULL, 0, buf, sizeof(buf), tag, sizeof(tag), buf) == 0 &&
+        memcmp(buf, plaintext, sizeof(buf)) == 0;
+
+    // ֤ԭؽ
+    ok = ok && sm4_gcm_open_verify_first(&gcm_key, iv, sizeof(iv), NULL, 0, out, sizeof(out), tag, sizeof(tag), out) == 0 &&
+        memcmp(out, plaintext, sizeof(out)) == 0;
+
+    // αıǩܣֲ
+    memset(out, 0x5a, sizeof(out));
+    tag[3] ^= 0x10;
+    ok = ok && sm4_gcm_open_verify_first(&gcm_key, iv, sizeof(iv), NULL, 0, buf, sizeof(buf), tag, sizeof(tag), out) == -1;
+    for (size_t i = 0; i < sizeof(out); i++) {
+        if (out[i] != 0x5a) ok = 0;
+    }
+
+    if (ok) {
+        printf("Success: in-place and verify-first decryption, forged tag rejected before decrypting\n");
+    }
+    else {
+        printf("ERROR: in-place or verify-first decryption failed\n");
+    }
+
+    printf("\n");
+}
+
+// 10ɢ/ۼiovec
+void test_iovec() {
+    printf("=== Test 10: Scatter/Gather (iovec) ===\n");
+
+    uint8_t key[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    uint8_t iv[12] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98
+    };
+
+    sm4_gcm_key gcm_key;
+    sm4_gcm_key_init(&gcm_key, key);
+
+    uint8_t aad[20], plaintext[1500], expected[1500], tag[16], expected_tag[16];
+    for (size_t i = 0; i < sizeof(aad); i++) aad[i] = (uint8_t)(i + 0x40);
+    for (size_t i = 0; i < sizeof(plaintext); i++) plaintext[i] = (uint8_t)(i * 7 + 1);
+    sm4_gcm_seal(&gcm_key, iv, sizeof(iv), aad, sizeof(aad), plaintext, sizeof(plaintext),
+        expected, expected_tag, sizeof(expected_tag));
+
+    // 밴600/500/400з֣1000/500з֣AAD
+    uint8_t cipher[1500], plain[1500];
+    sm4_gcm_iovec aad_iov[2] = { { aad, 13 }, { aad + 13, 7 } };
+    sm4_gcm_iovec in_iov[3] = { { plaintext, 600 }, { plaintext + 600, 500 }, { plaintext + 1100, 400 } };
+    sm4_gcm_iovec out_iov[2] = { { cipher, 1000 }, { cipher + 1000, 500 } };
+    sm4_gcm_seal_iov(&gcm_key, iv, sizeof(iv), aad_iov, 2, in_iov, 3, out_iov, 2, tag, sizeof(tag));
+    int ok = memcmp(cipher, expected, sizeof(cipher)) == 0 && memcmp(tag, expected_tag, sizeof(tag)) == 0;
+
+    sm4_gcm_iovec c_iov[3] = { { cipher, 333 }, { cipher + 333, 0 }, { cipher + 333, 1167 } };
+    sm4_gcm_iovec p_iov[2] = { { plain, 750 }, { plain + 750, 750 } };
+    ok = ok && sm4_gcm_open_iov(&gcm_key, iv, sizeof(iv), aad_iov, 2, c_iov, 3, p_iov, 2, tag, sizeof(tag)) == 0 &&
+        memcmp(plain, plaintext, sizeof(plain)) == 0;
+
+    // αıǩ-1
+    tag[0] ^= 1;
+    ok = ok && sm4_gcm_open_iov(&gcm_key, iv, sizeof(iv), aad_iov, 2, c_iov, 3, p_iov, 2, tag, sizeof(tag)) == -1;
+    for (size_t i = 0; i < sizeof(plain); i++) {
+        if (plain[i] != 0) ok = 0;
+    }
+
+    if (ok) {
+        printf("Success: fragmented seal/open matches contiguous seal, forged tag rejected\n");
+    }
+    else {
+        printf("ERROR: scatter/gather result differs from contiguous seal\n");
+    }
+
+    printf("\n");
+}
+
+// 11: RFC 8998 ¼A.1SM4-GCM֪𰸣
+static int hex_to_bytes(const char* hex, uint8_t* out) {
+    size_t n = strlen(hex) / 2;
+    for (size_t i = 0; i < n; i++) {
+        unsigned v;
+        sscanf(hex + 2 * i, "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+    return (int)n;
+}
+
+void test_rfc8998_vector() {
+    printf("=== Test 11: RFC 8998 A.1 Known Answer ===\n");
+
+    uint8_t key[16], iv[12], aad[20], plain[64], expected[64], expected_tag[16];
+    hex_to_bytes("0123456789ABCDEFFEDCBA9876543210", key);
+    hex_to_bytes("00001234567800000000ABCD", iv);
+    hex_to_bytes("FEEDFACEDEADBEEFFEEDFACEDEADBEEFABADDAD2", aad);
+    hex_to_bytes("AAAAAAAAAAAAAAAABBBBBBBBBBBBBBBBCCCCCCCCCCCCCCCCDDDDDDDDDDDDDDDD"
+        "EEEEEEEEEEEEEEEEFFFFFFFFFFFFFFFFEEEEEEEEEEEEEEEEAAAAAAAAAAAAAAAA", plain);
+    hex_to_bytes("17F399F08C67D5EE19D0DC9969C4BB7D5FD46FD3756489069157B282BB200735"
+        "D82710CA5C22F0CCFA7CBF93D496AC15A56834CBCF98C397B4024A2691233B8D", expected);
+    hex_to_bytes("83DE3541E4C2B58177E065A9BF7B62EC", expected_tag);
+
+    sm4_gcm_key gcm_key;
+    sm4_gcm_key_init(&gcm_key, key);
+    uint8_t cipher[64], opened[64], tag[16];
+    int ok = 1;
+
+    // seal
+    sm4_gcm_seal(&gcm_key, iv, sizeof(iv), aad, sizeof(aad), plain, sizeof(plain), cipher, tag, sizeof(tag));
+    int seal_ok = memcmp(cipher, expected, sizeof(expected)) == 0 && memcmp(tag, expected_tag, 16) == 0;
+    printf("seal:      %s\n", seal_ok ? "ok" : "ERROR");
+    ok &= seal_ok;
+
+    // open
+    int open_ok = sm4_gcm_open(&gcm_key, iv, sizeof(iv), aad, sizeof(aad), expected, sizeof(expected),
+        expected_tag, sizeof(expected_tag), opened) == 0 && memcmp(opened, plain, sizeof(plain)) == 0;
+    printf("open:      %s\n", open_ok ? "ok" : "ERROR");
+    ok &= open_ok;
+
+    // ʽܣĳȷֶ
+    static const size_t chunks[] = { 1, 15, 3, 16, 29 };
+    sm4_gcm_ctx ctx;
+    sm4_gcm_start(&ctx, &gcm_key, iv, sizeof(iv));
+    sm4_gcm_aad(&ctx, aad, 7);
+    sm4_gcm_aad(&ctx, aad + 7, sizeof(aad) - 7);
+    size_t off = 0;
+    for (int i = 0; off < sizeof(plain); i++) {
+        size_t n = chunks[i % 5] < sizeof(plain) - off ? chunks[i % 5] : sizeof(plain) - off;
+        sm4_gcm_crypt(&ctx, plain + off, cipher + off, n);
+        off += n;
+    }
+    sm4_gcm_tag(&ctx, tag, sizeof(tag));
+    int stream_ok = memcmp(cipher, expected, sizeof(expected)) == 0 && memcmp(tag, expected_tag, 16) == 0;
+
+    sm4_gcm_start(&ctx, &gcm_key, iv, sizeof(iv));
+    sm4_gcm_aad(&ctx, aad, sizeof(aad));
+    off = 0;
+    for (int i = 0; off < sizeof(plain); i++) {
+        size_t n = chunks[(i + 2) % 5] < sizeof(plain) - off ? chunks[(i + 2) % 5] : sizeof(plain) - off;
+        sm4_gcm_decrypt_update(&ctx, expected + off, opened + off, n);
+        off += n;
+    }
+    stream_ok &= sm4_gcm_verify(&ctx, expected_tag, sizeof(expected_tag)) == 0 &&
+        memcmp(opened, plain, sizeof(plain)) == 0;
+    printf("streaming: %s\n", stream_ok ? "ok" : "ERROR");
+    ok &= stream_ok;
+
+    if (ok) {
+        printf("Success: output matches RFC 8998 test vector\n");
+    }
+    else {
+        printf("ERROR: output differs from RFC 8998 test vector\n");
+    }
+
+    printf("\n");
+}
+
+// 12: GHASHʵλοʵֶԱȣblocks/update/mul/pow
+// 8ۺϵβ
+void test_ghash_impls() {
+    printf("=== Test 12: GHASH Implementations (%d-bit table) ===\n", SM4_GHASH_TABLE_BITS);
+
+    static const size_t nblocks[] = { 0, 1, 3, 7, 8, 9, 16, 17, 63 };
+    static const uint64_t powers[] = { 0, 1, 2, 7, 8, 9, 4096, 0x123456789ULL };
+    uint8_t data[63 * 16 + 5];
+    int all_ok = 1;
+
+    for (int impl = SM4_GHASH_CLMUL; impl < SM4_GHASH_BITWISE; impl++) {
+        int ok = 1;
+        int supported = 1;
+        for (int trial = 0; trial < 20 && supported; trial++) {
+            uint8_t H[16], X[16], Y[16];
+            for (int i = 0; i < 16; i++) {
+                H[i] = (uint8_t)rand();
+                X[i] = (uint8_t)rand();
+                Y[i] = (uint8_t)rand();
+            }
+            for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)rand();
+
+            sm4_ghash_key key, ref;
+            sm4_ghash_init(&key, H);
+            sm4_ghash_init(&ref, H);
+            sm4_ghash_set_impl(&ref, SM4_GHASH_BITWISE);
+            if (sm4_ghash_set_impl(&key, (sm4_ghash_impl)impl) != 0) {
+                supported = 0;
+                break;
+            }
+
+            uint8_t a[16], b[16];
+            for (size_t i = 0; i < sizeof(nblocks) / sizeof(nblocks[0]); i++) {
+                memcpy(a, X, 16);
+                memcpy(b, X, 16);
+                sm4_ghash_blocks(&key, a, data, nblocks[i]);
+                sm4_ghash_blocks(&ref, b, data, nblocks[i]);
+                ok &= memcmp(a, b, 16) == 0;
+            }
+
+            memcpy(a, X, 16);
+            memcpy(b, X, 16);
+            sm4_ghash_update(&key, a, data, sizeof(data));
+            sm4_ghash_update(&ref, b, data, sizeof(data));
+            ok &= memcmp(a, b, 16) == 0;
+
+            memcpy(a, X, 16);
+            memcpy(b, X, 16);
+            sm4_ghash_mul(&key, a, Y);
+            sm4_ghash_mul(&ref, b, Y);
+            ok &= memcmp(a, b, 16) == 0;
+
+            for (size_t i = 0; i < sizeof(powers) / sizeof(powers[0]); i++) {
+                sm4_ghash_pow(&key, powers[i], a);
+                sm4_ghash_pow(&ref, powers[i], b);
+                ok &= memcmp(a, b, 16) == 0;
+            }
+        }
+
+        if (!supported) {
+            printf("%-8s: not supported on this CPU\n", sm4_ghash_impl_name((sm4_ghash_impl)impl));
+            continue;
+        }
+        printf("%-8s: %s\n", sm4_ghash_impl_name((sm4_ghash_impl)impl), ok ? "matches bitwise" : "ERROR: mismatch");
+        all_ok &= ok;
+    }
+
+    if (all_ok) {
+        printf("Success: all GHASH implementations agree\n");
+    }
+    else {
+        printf("ERROR: GHASH implementations differ\n");
+    }
+
+    printf("\n");
+}
+
 int main() {
     printf("SM4-GCM Implementation Test\n\n");
 
@@ -245,6 +727,14 @@ int main() {
     test_authentication_failure();
     test_empty_aad_and_plaintext();
     test_long_message();
+    test_streaming();
+    test_key_reuse();
+    test_batch();
+    test_multithread();
+    test_inplace_and_verify_first();
+    test_iovec();
+    test_rfc8998_vector();
+    test_ghash_impls();
 
     printf("All tests completed.\n");
     return 0;
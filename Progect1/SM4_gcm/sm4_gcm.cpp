@@ -1,156 +1,170 @@
 #include "sm4_gcm.h"
 #include <stdlib.h>
+#include <emmintrin.h>
+
+// ====== CTR + GHASH =====
+// 鰴SM4ںˣAVX2һ8飬GFNIһ16飩õĺ
+// ŶԱGHASHȺβ͸ĺãʵʱ
+// ECBGHASHִ֮ͣвöص
+
+#define SM4_GCM_BATCH 16
+
+// out = a ^ bnֽڣ16ֽSSE2򡣰ֽдѭ-O2out
+// صᱻڴGCMԼռ֮һʱ䡣֧ out == a
+static inline void xor_bytes(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(x, y));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
 
-// SM4 S
-static const uint8_t SM4_SBOX[256] = {
-    0xd6,0x90,0xe9,0xfe,0xcc,0xe1,0x3d,0xb7,0x16,0xb6,0x14,0xc2,0x28,0xfb,0x2c,0x05,
-    0x2b,0x67,0x9a,0x76,0x2a,0xbe,0x04,0xc3,0xaa,0x44,0x13,0x26,0x49,0x86,0x06,0x99,
-    0x9c,0x42,0x50,0xf4,0x91,0xef,0x98,0x7a,0x33,0x54,0x0b,0x43,0xed,0xcf,0xac,0x62,
-    0xe4,0xb3,0x1c,0xa9,0xc9,0x08,0xe8,0x95,0x80,0xdf,0x94,0xfa,0x75,0x8f,0x3f,0xa6,
-    0x47,0x07,0xa7,0xfc,0xf3,0x73,0x17,0xba,0x83,0x59,0x3c,0x19,0xe6,0x85,0x4f,0xa8,
-    0x68,0x6b,0x81,0xb2,0x71,0x64,0xda,0x8b,0xf8,0xeb,0x0f,0x4b,0x70,0x56,0x9d,0x35,
-    0x1e,0x24,0x0e,0x5e,0x63,0x58,0xd1,0xa2,0x25,0x22,0x7c,0x3b,0x01,0x21,0x78,0x87,
-    0xd4,0x00,0x46,0x57,0x9f,0xd3,0x27,0x52,0x4c,0x36,0x02,0xe7,0xa0,0xc4,0xc8,0x9e,
-    0xea,0xbf,0x8a,0xd2,0x40,0xc7,0x38,0xb5,0xa3,0xf7,0xf2,0xce,0xf9,0x61,0x15,0xa1,
-    0xe0,0xae,0x5d,0xa4,0x9b,0x34,0x1a,0x55,0xad,0x93,0x32,0x30,0xf5,0x8c,0xb1,0xe3,
-    0x1d,0xf6,0xe2,0x2e,0x82,0x66,0xca,0x60,0xc0,0x29,0x23,0xab,0x0d,0x53,0x4e,0x6f,
-    0xd5,0xdb,0x37,0x45,0xde,0xfd,0x8e,0x2f,0x03,0xff,0x6a,0x72,0x6d,0x6c,0x5b,0x51,
-    0x8d,0x1b,0xaf,0x92,0xbb,0xdd,0xbc,0x7f,0x11,0xd9,0x5c,0x41,0x1f,0x10,0x5a,0xd8,
-    0x0a,0xc1,0x31,0x88,0xa5,0xcd,0x7b,0xbd,0x2d,0x74,0xd0,0x12,0xb8,0xe5,0xb4,0xb0,
-    0x89,0x69,0x97,0x4a,0x0c,0x96,0x77,0x7e,0x65,0xb9,0xf1,0x09,0xc5,0x6e,0xc6,0x84,
-    0x18,0xf0,0x7d,0xec,0x3a,0xdc,0x4d,0x20,0x79,0xee,0x5f,0x3e,0xd7,0xcb,0x39,0x48,
-};
-
-// ѭ
-#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
-
-// SM4ֺ
-static inline uint32_t sm4_round(uint32_t x) {
-    uint32_t t = SM4_SBOX[(uint8_t)(x >> 24)] << 24 |
-        SM4_SBOX[(uint8_t)(x >> 16)] << 16 |
-        SM4_SBOX[(uint8_t)(x >> 8)] << 8 |
-        SM4_SBOX[(uint8_t)x];
-    return t ^ ROTL32(t, 2) ^ ROTL32(t, 10) ^ ROTL32(t, 18) ^ ROTL32(t, 24);
+// n飬ֻе32λGCMinc32
+static void gcm_counters(const uint8_t base[16], uint32_t ctr, uint8_t* blocks, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t c = ctr + (uint32_t)i;
+        memcpy(blocks + 16 * i, base, 12);
+        blocks[16 * i + 12] = (uint8_t)(c >> 24);
+        blocks[16 * i + 13] = (uint8_t)(c >> 16);
+        blocks[16 * i + 14] = (uint8_t)(c >> 8);
+        blocks[16 * i + 15] = (uint8_t)c;
+    }
 }
 
-// SM4Կ
-static void sm4_key_schedule(const uint8_t* key, uint32_t* rk) {
-    uint32_t k[4];
-    const uint32_t FK[4] = { 0xa3b1bac6, 0x56aa3350, 0x677d9197, 0xb27022dc };
-    const uint32_t CK[32] = {
-        0x00070e15, 0x1c232a31, 0x383f464d, 0x545b6269,
-        // ... CKʡ
-    };
+// CTRӽlenֽڣͬʱսGHASH״̬YYΪNULLʱֻCTR
+// Ϊ baseǰ96λ || ctrʱoutʱininoutͬ
+static void gcm_ctr_ghash(const sm4_gcm_key* key, uint8_t Y[16], const uint8_t base[16], uint32_t ctr,
+    const uint8_t* in, uint8_t* out, size_t len, int decrypt) {
+    uint8_t ctrs[SM4_GCM_BATCH * 16];
+    uint8_t ks[SM4_GCM_BATCH * 16];
+
+    while (len > 0) {
+        size_t n = len < sizeof(ks) ? len : sizeof(ks);
+        size_t nblocks = (n + 15) / 16;
+
+        gcm_counters(base, ctr, ctrs, nblocks);
+        ctr += (uint32_t)nblocks;
+        sm4_encrypt_blocks(key->rk, ctrs, ks, nblocks);
+
+        // ֻһܲһ飬sm4_ghash_update0ա
+        // ԭؽʱڸ֮ǰձ
+        if (Y != NULL && decrypt) {
+            sm4_ghash_update(&key->ghash, Y, in, n);
+        }
+        xor_bytes(out, in, ks, n);
+        if (Y != NULL && !decrypt) {
+            sm4_ghash_update(&key->ghash, Y, out, n);
+        }
 
-    // Կ
-    for (int i = 0; i < 4; i++) {
-        k[i] = ((uint32_t)key[4 * i] << 24) | ((uint32_t)key[4 * i + 1] << 16) |
-            ((uint32_t)key[4 * i + 2] << 8) | (uint32_t)key[4 * i + 3];
-        k[i] ^= FK[i];
+        in += n;
+        out += n;
+        len -= n;
     }
+}
 
+// չԿԤH
+void sm4_gcm_key_init(sm4_gcm_key* key, const uint8_t k[SM4_KEY_SIZE]) {
     // Կ
-    for (int i = 0; i < SM4_NUM_ROUNDS; i++) {
-        uint32_t x = k[(i + 1) % 4] ^ k[(i + 2) % 4] ^ k[(i + 3) % 4] ^ CK[i];
-        x = sm4_round(x);
-        rk[i] = k[i % 4] ^ x;
-        k[i % 4] = rk[i];
-    }
-}
+    sm4_key_schedule(k, key->rk);
 
-// SM4
-static void sm4_encrypt_block(const uint32_t* rk, const uint8_t* in, uint8_t* out) {
-    uint32_t x[4];
+    // H = E_K(0^128)ԤGHASHõHĸ
+    uint8_t H[SM4_BLOCK_SIZE] = { 0 };
+    sm4_encrypt_block(H, H, key->rk);
+    sm4_ghash_init(&key->ghash, H);
+}
 
-    // 
-    for (int i = 0; i < 4; i++) {
-        x[i] = ((uint32_t)in[4 * i] << 24) | ((uint32_t)in[4 * i + 1] << 16) |
-            ((uint32_t)in[4 * i + 2] << 8) | (uint32_t)in[4 * i + 3];
-    }
+// ɽӿڣԿչs->keys->ctx
+void sm4_gcm_init(sm4_gcm_keyed_ctx* s, const uint8_t* key, const uint8_t* iv, size_t iv_len) {
+    sm4_gcm_key_init(&s->key, key);
+    sm4_gcm_start(&s->ctx, &s->key, iv, iv_len);
+}
 
-    // 32ּ
-    for (int i = 0; i < SM4_NUM_ROUNDS; i++) {
-        uint32_t t = x[(i + 1) % 4] ^ x[(i + 2) % 4] ^ x[(i + 3) % 4] ^ rk[i];
-        t = sm4_round(t);
-        x[i % 4] ^= t;
-    }
+// ====== ߳ =====
+// 鲿ְ64 KiBжΣ̳߳϶CTR0ʼĲGHASH
+//   Y_i = X_1H^n ^ X_2H^(n-1) ^ ... ^ X_nH
+// ˳ϲ acc = accH^n_i ^ Y_i õ뵥߳ͬGHASHÿദ
+// SM4_GCM_MT_ROUND Σֽջϣڴռݳ޹ء
+
+#define SM4_GCM_MT_CHUNK (64 * 1024)   // ÿ64 KiB4096
+#define SM4_GCM_MT_MIN (256 * 1024)    // Сڸóʱֱӵ̴߳
+#define SM4_GCM_MT_ROUND 256           // ÿֶ
+
+struct gcm_mt_job {
+    const sm4_gcm_key* key;
+    const uint8_t* base;
+    uint32_t ctr;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t len;
+    int decrypt;
+    uint8_t (*Y)[16];
+};
 
-    // 
-    for (int i = 0; i < 4; i++) {
-        out[4 * i] = (uint8_t)(x[3 - i] >> 24);
-        out[4 * i + 1] = (uint8_t)(x[3 - i] >> 16);
-        out[4 * i + 2] = (uint8_t)(x[3 - i] >> 8);
-        out[4 * i + 3] = (uint8_t)x[3 - i];
+static void gcm_mt_chunks(void* arg, size_t begin, size_t end) {
+    const gcm_mt_job* job = (const gcm_mt_job*)arg;
+    for (size_t c = begin; c < end; c++) {
+        size_t off = c * SM4_GCM_MT_CHUNK;
+        size_t len = job->len - off < SM4_GCM_MT_CHUNK ? job->len - off : SM4_GCM_MT_CHUNK;
+        memset(job->Y[c], 0, 16);
+        gcm_ctr_ghash(job->key, job->Y[c], job->base, job->ctr + (uint32_t)(off / 16),
+            job->in + off, job->out + off, len, job->decrypt);
     }
 }
 
-// GF(2^128)˷ (ʹòŻ)
-static void gf128_mul(uint8_t* x, const uint8_t* y) {
-    uint8_t z[16] = { 0 };
-    uint8_t v[16];
-    memcpy(v, y, 16);
-
-    for (int i = 0; i < 16; i++) {
-        uint8_t c = x[i];
-        for (int j = 0; j < 8; j++) {
-            if (c & (1 << (7 - j))) {
-                for (int k = 0; k < 16; k++) {
-                    z[k] ^= v[k];
-                }
+// gcm_ctr_ghashͬlenΪ16ı
+static void gcm_ctr_ghash_mt(const sm4_gcm_key* key, uint8_t X[16], const uint8_t base[16], uint32_t ctr,
+    const uint8_t* in, uint8_t* out, size_t len, int decrypt) {
+    uint8_t Y[SM4_GCM_MT_ROUND][16];
+    uint8_t Hc[16];
+    sm4_ghash_pow(&key->ghash, SM4_GCM_MT_CHUNK / 16, Hc);
+
+    while (len > 0) {
+        size_t n = len < (size_t)SM4_GCM_MT_ROUND * SM4_GCM_MT_CHUNK ? len : (size_t)SM4_GCM_MT_ROUND * SM4_GCM_MT_CHUNK;
+        size_t nchunks = (n + SM4_GCM_MT_CHUNK - 1) / SM4_GCM_MT_CHUNK;
+        gcm_mt_job job = { key, base, ctr, in, out, n, decrypt, Y };
+        sm4_parallel_for(nchunks, 1, gcm_mt_chunks, &job);
+
+        // ˳ϲһοܲ
+        for (size_t c = 0; c < nchunks; c++) {
+            size_t clen = n - c * SM4_GCM_MT_CHUNK < SM4_GCM_MT_CHUNK ? n - c * SM4_GCM_MT_CHUNK : SM4_GCM_MT_CHUNK;
+            if (clen == SM4_GCM_MT_CHUNK) {
+                sm4_ghash_mul(&key->ghash, X, Hc);
             }
-
-            int carry = v[15] & 0x01;
-            for (int k = 15; k > 0; k--) {
-                v[k] = (v[k] >> 1) | ((v[k - 1] & 0x01) << 7);
+            else {
+                uint8_t Hn[16];
+                sm4_ghash_pow(&key->ghash, clen / 16, Hn);
+                sm4_ghash_mul(&key->ghash, X, Hn);
             }
-            v[0] >>= 1;
-            if (carry) {
-                v[0] ^= 0xe1;
+            for (int j = 0; j < 16; j++) {
+                X[j] ^= Y[c][j];
             }
         }
-    }
 
-    memcpy(x, z, 16);
+        ctr += (uint32_t)(n / 16);
+        in += n;
+        out += n;
+        len -= n;
+    }
 }
 
-// ʼSM4-GCM
-void sm4_gcm_init(sm4_gcm_ctx* ctx, const uint8_t* key, const uint8_t* iv, size_t iv_len) {
-    // Կ
-    sm4_key_schedule(key, ctx->rk);
-
-    // H = E_K(0^128)
-    memset(ctx->H, 0, SM4_BLOCK_SIZE);
-    sm4_encrypt_block(ctx->rk, ctx->H, ctx->H);
-
-    // J0 (ʼ)
+// J0 (ʼ)
+static void gcm_compute_j0(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len, uint8_t J0[16]) {
     if (iv_len == 12) {
-        memcpy(ctx->J0, iv, 12);
-        ctx->J0[12] = ctx->J0[13] = ctx->J0[14] = 0;
-        ctx->J0[15] = 1;
+        memcpy(J0, iv, 12);
+        J0[12] = J0[13] = J0[14] = 0;
+        J0[15] = 1;
     }
     else {
         // GHASHJ0 = GHASH_H(IV || 0^(s) || len(IV))
-        memset(ctx->J0, 0, SM4_BLOCK_SIZE);
-        size_t iv_blocks = (iv_len + 15) / 16;
-        size_t pad_len = iv_blocks * 16 - iv_len;
+        memset(J0, 0, SM4_BLOCK_SIZE);
+        sm4_ghash_update(&key->ghash, J0, iv, iv_len);
 
         uint8_t ghash_in[16] = { 0 };
         uint64_t iv_len_bits = iv_len * 8;
-
-        for (size_t i = 0; i < iv_blocks; i++) {
-            size_t copy_len = (i == iv_blocks - 1) ? (16 - pad_len) : 16;
-            memcpy(ghash_in, iv + i * 16, copy_len);
-            if (i == iv_blocks - 1 && pad_len > 0) {
-                memset(ghash_in + copy_len, 0, pad_len);
-            }
-
-            for (int j = 0; j < 16; j++) {
-                ctx->J0[j] ^= ghash_in[j];
-            }
-            gf128_mul(ctx->J0, ctx->H);
-        }
-
-        memset(ghash_in, 0, 16);
         ghash_in[8] = (uint8_t)(iv_len_bits >> 56);
         ghash_in[9] = (uint8_t)(iv_len_bits >> 48);
         ghash_in[10] = (uint8_t)(iv_len_bits >> 40);
@@ -159,105 +173,193 @@ void sm4_gcm_init(sm4_gcm_ctx* ctx, const uint8_t* key, const uint8_t* iv, size_
         ghash_in[13] = (uint8_t)(iv_len_bits >> 16);
         ghash_in[14] = (uint8_t)(iv_len_bits >> 8);
         ghash_in[15] = (uint8_t)iv_len_bits;
-
-        for (int j = 0; j < 16; j++) {
-            ctx->J0[j] ^= ghash_in[j];
-        }
-        gf128_mul(ctx->J0, ctx->H);
+        sm4_ghash_blocks(&key->ghash, J0, ghash_in, 1);
     }
+}
+
+// ctx->J0ʼһϢ
+static void gcm_reset(sm4_gcm_ctx* ctx, const sm4_gcm_key* key) {
+    ctx->key = key;
+
+    // һݿʹ inc32(J0)
+    ctx->ctr = (((uint32_t)ctx->J0[12] << 24) | ((uint32_t)ctx->J0[13] << 16) |
+        ((uint32_t)ctx->J0[14] << 8) | (uint32_t)ctx->J0[15]) + 1;
 
+    memset(ctx->X, 0, SM4_BLOCK_SIZE);
+    ctx->buf_len = 0;
+    ctx->in_payload = 0;
     ctx->len_aad = 0;
+    ctx->has_ej0 = 0;
     ctx->len_plain = 0;
 }
 
+// չԿʼһϢ
+void sm4_gcm_start(sm4_gcm_ctx* ctx, const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len) {
+    gcm_compute_j0(key, iv, iv_len, ctx->J0);
+    gcm_reset(ctx, key);
+}
+
 // ֤(AAD)
-void sm4_gcm_aad(sm4_gcm_ctx* ctx, const uint8_t* aad, size_t aad_len) {
-    uint8_t ghash_in[16] = { 0 };
-    size_t aad_blocks = (aad_len + 15) / 16;
-    size_t pad_len = aad_blocks * 16 - aad_len;
-
-    for (size_t i = 0; i < aad_blocks; i++) {
-        size_t copy_len = (i == aad_blocks - 1) ? (16 - pad_len) : 16;
-        memcpy(ghash_in, aad + i * 16, copy_len);
-        if (i == aad_blocks - 1 && pad_len > 0) {
-            memset(ghash_in + copy_len, 0, pad_len);
-        }
+int sm4_gcm_aad(sm4_gcm_ctx* ctx, const uint8_t* aad, size_t aad_len) {
+    if (ctx->in_payload) {
+        return -1;
+    }
+    ctx->len_aad += aad_len;
 
-        for (int j = 0; j < 16; j++) {
-            ctx->J0[j] ^= ghash_in[j];
+    // ȴϴʣµĲ
+    if (ctx->buf_len > 0) {
+        size_t n = 16 - ctx->buf_len < aad_len ? 16 - ctx->buf_len : aad_len;
+        memcpy(ctx->buf + ctx->buf_len, aad, n);
+        ctx->buf_len += n;
+        aad += n;
+        aad_len -= n;
+        if (ctx->buf_len < 16) {
+            return 0;
         }
-        gf128_mul(ctx->J0, ctx->H);
+        sm4_ghash_blocks(&ctx->key->ghash, ctx->X, ctx->buf, 1);
+        ctx->buf_len = 0;
     }
 
-    ctx->len_aad += aad_len;
+    // ֱӴӵڴգʣಿ´
+    sm4_ghash_blocks(&ctx->key->ghash, ctx->X, aad, aad_len / 16);
+    ctx->buf_len = aad_len % 16;
+    memcpy(ctx->buf, aad + aad_len - ctx->buf_len, ctx->buf_len);
+    return 0;
 }
 
-// /ܴ
-void sm4_gcm_crypt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len) {
-    uint8_t counter[16];
-    uint8_t keystream[16];
-    uint8_t ghash_in[16] = { 0 };
+// AADһAAD0
+static void gcm_begin_payload(sm4_gcm_ctx* ctx) {
+    if (ctx->buf_len > 0) {
+        sm4_ghash_update(&ctx->key->ghash, ctx->X, ctx->buf, ctx->buf_len);
+    }
+    ctx->buf_len = 0;
+    ctx->in_payload = 1;
+}
 
-    size_t blocks = len / 16;
-    size_t remainder = len % 16;
+// һμӽʱһδlenֽڣksΪ E_K(J0) ֮lenֽԿ
+static void gcm_apply_keystream(sm4_gcm_ctx* ctx, const uint8_t* ks, const uint8_t* in, uint8_t* out,
+    size_t len, int decrypt) {
+    memcpy(ctx->EJ0, ks, 16);
+    ctx->has_ej0 = 1;
+    ks += 16;
 
-    memcpy(counter, ctx->J0, 16);
+    size_t full = len & ~(size_t)15;
+    if (decrypt) {
+        sm4_ghash_blocks(&ctx->key->ghash, ctx->X, in, full / 16);
+    }
+    xor_bytes(out, in, ks, full);
+    if (!decrypt) {
+        sm4_ghash_blocks(&ctx->key->ghash, ctx->X, out, full / 16);
+    }
 
-    // 
-    for (size_t i = 0; i < blocks; i++) {
-        // Ӽ
-        for (int j = 15; j >= 12; j--) {
-            if (++counter[j] != 0) break;
+    // һĲʽһbuf/ks
+    ctx->buf_len = len - full;
+    if (ctx->buf_len > 0) {
+        memcpy(ctx->ks, ks + full, 16);
+        // bufģʱҪԭظ֮ǰȡ
+        if (decrypt) {
+            memcpy(ctx->buf, in + full, ctx->buf_len);
         }
-
-        // Կ
-        sm4_encrypt_block(ctx->rk, counter, keystream);
-
-        // /
-        for (int j = 0; j < 16; j++) {
-            out[i * 16 + j] = in[i * 16 + j] ^ keystream[j];
-            ghash_in[j] = out[i * 16 + j];
+        xor_bytes(out + full, in + full, ctx->ks, ctx->buf_len);
+        if (!decrypt) {
+            memcpy(ctx->buf, out + full, ctx->buf_len);
         }
+    }
+    ctx->ctr += (uint32_t)((len + 15) / 16);
+    ctx->len_plain += len;
+}
 
-        // GHASH
-        for (int j = 0; j < 16; j++) {
-            ctx->J0[j] ^= ghash_in[j];
+static void gcm_update(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len, int decrypt, int mt) {
+    if (!ctx->in_payload) {
+        gcm_begin_payload(ctx);
+
+        // ϢJ0ȫͬһζʡǩʱJ0
+        // һʱںҪһ絥J0
+        size_t nblocks = (len + 15) / 16;
+        if (len > 0 && nblocks < SM4_GCM_BATCH) {
+            uint8_t ctrs[SM4_GCM_BATCH * 16];
+            uint8_t ks[SM4_GCM_BATCH * 16];
+            gcm_counters(ctx->J0, ctx->ctr - 1, ctrs, nblocks + 1);
+            sm4_encrypt_blocks(ctx->key->rk, ctrs, ks, nblocks + 1);
+            gcm_apply_keystream(ctx, ks, in, out, len, decrypt);
+            return;
         }
-        gf128_mul(ctx->J0, ctx->H);
     }
+    ctx->len_plain += len;
 
-    // ʣಿ
-    if (remainder > 0) {
-        // Ӽ
-        for (int j = 15; j >= 12; j--) {
-            if (++counter[j] != 0) break;
+    // ϴʣµԿĴսbuf
+    if (ctx->buf_len > 0) {
+        size_t n = 16 - ctx->buf_len < len ? 16 - ctx->buf_len : len;
+        for (size_t j = 0; j < n; j++) {
+            uint8_t c = decrypt ? in[j] : (uint8_t)(in[j] ^ ctx->ks[ctx->buf_len + j]);
+            out[j] = in[j] ^ ctx->ks[ctx->buf_len + j];
+            ctx->buf[ctx->buf_len + j] = c;
         }
-
-        // Կ
-        sm4_encrypt_block(ctx->rk, counter, keystream);
-
-        // /
-        for (size_t j = 0; j < remainder; j++) {
-            out[blocks * 16 + j] = in[blocks * 16 + j] ^ keystream[j];
-            ghash_in[j] = out[blocks * 16 + j];
+        ctx->buf_len += n;
+        in += n;
+        out += n;
+        len -= n;
+        if (ctx->buf_len < 16) {
+            return;
         }
+        sm4_ghash_blocks(&ctx->key->ghash, ctx->X, ctx->buf, 1);
+        ctx->buf_len = 0;
+    }
 
-        // 0
-        memset(ghash_in + remainder, 0, 16 - remainder);
+    // ֱڵڴCTR+GHASH
+    size_t full = len & ~(size_t)15;
+    if (full > 0) {
+        if (mt && full >= SM4_GCM_MT_MIN && sm4_get_num_threads() > 1) {
+            gcm_ctr_ghash_mt(ctx->key, ctx->X, ctx->J0, ctx->ctr, in, out, full, decrypt);
+        }
+        else {
+            gcm_ctr_ghash(ctx->key, ctx->X, ctx->J0, ctx->ctr, in, out, full, decrypt);
+        }
+        ctx->ctr += (uint32_t)(full / 16);
+        in += full;
+        out += full;
+        len -= full;
+    }
 
-        // GHASH
-        for (int j = 0; j < 16; j++) {
-            ctx->J0[j] ^= ghash_in[j];
+    // βһԿʣಿ´ε
+    if (len > 0) {
+        uint8_t cb[16];
+        memcpy(cb, ctx->J0, 12);
+        cb[12] = (uint8_t)(ctx->ctr >> 24);
+        cb[13] = (uint8_t)(ctx->ctr >> 16);
+        cb[14] = (uint8_t)(ctx->ctr >> 8);
+        cb[15] = (uint8_t)ctx->ctr;
+        ctx->ctr++;
+        sm4_encrypt_block(cb, ctx->ks, ctx->key->rk);
+        for (size_t j = 0; j < len; j++) {
+            uint8_t c = decrypt ? in[j] : (uint8_t)(in[j] ^ ctx->ks[j]);
+            out[j] = in[j] ^ ctx->ks[j];
+            ctx->buf[j] = c;
         }
-        gf128_mul(ctx->J0, ctx->H);
+        ctx->buf_len = len;
     }
+}
 
-    ctx->len_plain += len;
+// /ܴ
+void sm4_gcm_crypt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len) {
+    gcm_update(ctx, in, out, len, 0, 0);
+}
+
+void sm4_gcm_decrypt_update(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len) {
+    gcm_update(ctx, in, out, len, 1, 0);
+}
+
+void sm4_gcm_crypt_mt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len) {
+    gcm_update(ctx, in, out, len, 0, 1);
 }
 
-// ֤ǩ
-void sm4_gcm_tag(sm4_gcm_ctx* ctx, uint8_t* tag, size_t tag_len) {
-    uint8_t S[16] = { 0 };
+void sm4_gcm_decrypt_update_mt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len) {
+    gcm_update(ctx, in, out, len, 1, 1);
+}
+
+// ֤ǩ޸ctx
+void sm4_gcm_tag(const sm4_gcm_ctx* ctx, uint8_t* tag, size_t tag_len) {
+    uint8_t S[16];
     uint8_t len_block[16];
     uint64_t aad_len_bits = ctx->len_aad * 8;
     uint64_t plain_len_bits = ctx->len_plain * 8;
@@ -282,15 +384,20 @@ void sm4_gcm_tag(sm4_gcm_ctx* ctx, uint8_t* tag, size_t tag_len) {
     len_block[15] = (uint8_t)plain_len_bits;
 
     // S = GHASH_H(AAD || Ciphertext || len(AAD) || len(Ciphertext))
-    memcpy(S, ctx->J0, 16);
-    for (int i = 0; i < 16; i++) {
-        S[i] ^= len_block[i];
+    memcpy(S, ctx->X, 16);
+    if (ctx->buf_len > 0) {
+        sm4_ghash_update(&ctx->key->ghash, S, ctx->buf, ctx->buf_len);
     }
-    gf128_mul(S, ctx->H);
+    sm4_ghash_blocks(&ctx->key->ghash, S, len_block, 1);
 
     // T = MSB_t(S + E_K(J0))
     uint8_t T[16];
-    sm4_encrypt_block(ctx->rk, ctx->J0, T);
+    if (ctx->has_ej0) {
+        memcpy(T, ctx->EJ0, 16);
+    }
+    else {
+        sm4_encrypt_block(ctx->J0, T, ctx->key->rk);
+    }
     for (int i = 0; i < 16; i++) {
         T[i] ^= S[i];
     }
@@ -302,15 +409,14 @@ void sm4_gcm_tag(sm4_gcm_ctx* ctx, uint8_t* tag, size_t tag_len) {
     }
 }
 
-// ܺ
-int sm4_gcm_encrypt(
-    const uint8_t* key, const uint8_t* iv, size_t iv_len,
+// Ϣܣkeysm4_gcm_key_initԤչ
+int sm4_gcm_seal(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
     const uint8_t* aad, size_t aad_len,
     const uint8_t* plain, size_t plain_len,
     uint8_t* cipher, uint8_t* tag, size_t tag_len) {
 
     sm4_gcm_ctx ctx;
-    sm4_gcm_init(&ctx, key, iv, iv_len);
+    sm4_gcm_start(&ctx, key, iv, iv_len);
 
     if (aad_len > 0) {
         sm4_gcm_aad(&ctx, aad, aad_len);
@@ -322,32 +428,332 @@ int sm4_gcm_encrypt(
     return 0;
 }
 
-// ֤
-int sm4_gcm_decrypt(
-    const uint8_t* key, const uint8_t* iv, size_t iv_len,
+// ʱȽϣʱһֽͬڵλ޹
+static int gcm_tag_cmp(const uint8_t* a, const uint8_t* b, size_t n) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < n; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff != 0 ? -1 : 0;
+}
+
+int sm4_gcm_verify(const sm4_gcm_ctx* ctx, const uint8_t* tag, size_t tag_len) {
+    if (tag_len == 0 || tag_len > 16) {
+        return -1;
+    }
+    uint8_t computed_tag[16];
+    sm4_gcm_tag(ctx, computed_tag, sizeof(computed_tag));
+    return gcm_tag_cmp(computed_tag, tag, tag_len);
+}
+
+// Ϣ֤һɣ߽ܱGHASH
+int sm4_gcm_open(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
     const uint8_t* aad, size_t aad_len,
     const uint8_t* cipher, size_t cipher_len,
     const uint8_t* tag, size_t tag_len,
     uint8_t* plain) {
 
     sm4_gcm_ctx ctx;
-    sm4_gcm_init(&ctx, key, iv, iv_len);
+    sm4_gcm_start(&ctx, key, iv, iv_len);
 
     if (aad_len > 0) {
         sm4_gcm_aad(&ctx, aad, aad_len);
     }
 
-    uint8_t computed_tag[16] = { 0 };
-
-    // ȼǩ
-    sm4_gcm_crypt(&ctx, cipher, plain, cipher_len);
-    sm4_gcm_tag(&ctx, computed_tag, tag_len);
+    sm4_gcm_decrypt_update(&ctx, cipher, plain, cipher_len);
 
     // ֤ǩ
-    if (memcmp(computed_tag, tag, tag_len) != 0) {
+    if (sm4_gcm_verify(&ctx, tag, tag_len) != 0) {
         memset(plain, 0, cipher_len); // ܽ
         return -1; // ֤ʧ
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+// ֤ܣһֻGHASHǩȷڶCTR
+// αϢдplainҲ
+int sm4_gcm_open_verify_first(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* cipher, size_t cipher_len,
+    const uint8_t* tag, size_t tag_len,
+    uint8_t* plain) {
+
+    sm4_gcm_ctx ctx;
+    sm4_gcm_start(&ctx, key, iv, iv_len);
+
+    if (aad_len > 0) {
+        sm4_gcm_aad(&ctx, aad, aad_len);
+    }
+
+    // һ飺ֻģһ鲹0
+    gcm_begin_payload(&ctx);
+    sm4_ghash_update(&key->ghash, ctx.X, cipher, cipher_len);
+    ctx.len_plain = cipher_len;
+
+    if (sm4_gcm_verify(&ctx, tag, tag_len) != 0) {
+        return -1; // ֤ʧ
+    }
+
+    // ڶ飺CTR
+    gcm_ctr_ghash(key, NULL, ctx.J0, ctx.ctr, cipher, plain, cipher_len, 1);
+    return 0;
+}
+
+// ܺ
+int sm4_gcm_encrypt(
+    const uint8_t* key, const uint8_t* iv, size_t iv_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* plain, size_t plain_len,
+    uint8_t* cipher, uint8_t* tag, size_t tag_len) {
+
+    sm4_gcm_key k;
+    sm4_gcm_key_init(&k, key);
+    return sm4_gcm_seal(&k, iv, iv_len, aad, aad_len, plain, plain_len, cipher, tag, tag_len);
+}
+
+// ֤
+int sm4_gcm_decrypt(
+    const uint8_t* key, const uint8_t* iv, size_t iv_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* cipher, size_t cipher_len,
+    const uint8_t* tag, size_t tag_len,
+    uint8_t* plain) {
+
+    sm4_gcm_key k;
+    sm4_gcm_key_init(&k, key);
+    return sm4_gcm_open(&k, iv, iv_len, aad, aad_len, cipher, cipher_len, tag, tag_len, plain);
+}
+
+// ====== Ϣ =====
+// ʹͬһԿϢѸԵ J0 ͼƴһһνںˣ
+// ϢҲ8/16·֮GHASHǩϢGHASH
+// ִпصϢĳ˷
+
+#define SM4_GCM_MB_BLOCKS 256  // һζķ
+#define SM4_GCM_MB_JOBS 64     // һϢ
+
+static void gcm_batch(sm4_gcm_job* jobs, size_t njobs, int decrypt) {
+    uint8_t J0[SM4_GCM_MB_JOBS][16];
+    uint8_t ctrs[SM4_GCM_MB_BLOCKS * 16];
+    uint8_t ks[SM4_GCM_MB_BLOCKS * 16];
+    sm4_gcm_ctx ctx;
+
+    size_t i = 0;
+    while (i < njobs) {
+        const sm4_gcm_key* key = jobs[i].key;
+
+        // ͷŲµĳϢֱͨӿ
+        if ((jobs[i].len + 15) / 16 + 1 > SM4_GCM_MB_BLOCKS) {
+            sm4_gcm_job* j = &jobs[i++];
+            if (decrypt) {
+                j->status = sm4_gcm_open(key, j->iv, j->iv_len, j->aad, j->aad_len,
+                    j->in, j->len, j->tag, j->tag_len, j->out);
+            }
+            else {
+                j->status = sm4_gcm_seal(key, j->iv, j->iv_len, j->aad, j->aad_len,
+                    j->in, j->len, j->out, j->tag, j->tag_len);
+            }
+            continue;
+        }
+
+        // ռͬһԿһϢJ0, inc32(J0), ...
+        size_t start = i, end = i, nblocks = 0;
+        while (end < njobs && end - start < SM4_GCM_MB_JOBS && jobs[end].key == key) {
+            size_t nb = (jobs[end].len + 15) / 16 + 1;
+            if (nblocks + nb > SM4_GCM_MB_BLOCKS) break;
+            uint8_t* j0 = J0[end - start];
+            gcm_compute_j0(key, jobs[end].iv, jobs[end].iv_len, j0);
+            uint32_t c = ((uint32_t)j0[12] << 24) | ((uint32_t)j0[13] << 16) |
+                ((uint32_t)j0[14] << 8) | (uint32_t)j0[15];
+            gcm_counters(j0, c, ctrs + 16 * nblocks, nb);
+            nblocks += nb;
+            end++;
+        }
+
+        sm4_encrypt_blocks(key->rk, ctrs, ks, nblocks);
+
+        // AAD    ǩ
+        const uint8_t* k = ks;
+        for (; i < end; i++) {
+            sm4_gcm_job* j = &jobs[i];
+            memcpy(ctx.J0, J0[i - start], 16);
+            gcm_reset(&ctx, key);
+            if (j->aad_len > 0) {
+                sm4_gcm_aad(&ctx, j->aad, j->aad_len);
+            }
+            gcm_begin_payload(&ctx);
+            gcm_apply_keystream(&ctx, k, j->in, j->out, j->len, decrypt);
+            k += 16 * ((j->len + 15) / 16 + 1);
+
+            if (decrypt) {
+                j->status = sm4_gcm_verify(&ctx, j->tag, j->tag_len);
+                if (j->status != 0) {
+                    memset(j->out, 0, j->len); // ܽ
+                }
+            }
+            else {
+                sm4_gcm_tag(&ctx, j->tag, j->tag_len);
+                j->status = 0;
+            }
+        }
+    }
+}
+
+void sm4_gcm_seal_batch(sm4_gcm_job* jobs, size_t njobs) {
+    gcm_batch(jobs, njobs, 0);
+}
+
+int sm4_gcm_open_batch(sm4_gcm_job* jobs, size_t njobs) {
+    gcm_batch(jobs, njobs, 1);
+    int failed = 0;
+    for (size_t i = 0; i < njobs; i++) {
+        failed += jobs[i].status != 0;
+    }
+    return failed;
+}
+
+// ====== ɢ/ۼiovec=====
+// Կ̶ڣ64飩ɣƬ߽޹أںÿζһ
+// Ŀ0ΪJ0ٵܡڵķƬʱ˳дջϵС壨L1У
+// ƬķҲģһνGHASH
+// ķƬ߽ԲͬҪȰڴ档
+
+#define SM4_GCM_IOV_WINDOW (4 * SM4_GCM_BATCH)  // ÿڵĿ
+
+static size_t iov_total(const sm4_gcm_iovec* iov, size_t cnt) {
+    size_t total = 0;
+    for (size_t i = 0; i < cnt; i++) {
+        total += iov[i].len;
+    }
+    return total;
+}
+
+// ƬбϵĶдλ
+struct iov_cursor {
+    const sm4_gcm_iovec* iov;
+    size_t idx;
+    size_t off;
+};
+
+// ͿյķƬصǰƬʣֽ
+static size_t iov_avail(iov_cursor* c) {
+    while (c->off == c->iov[c->idx].len) {
+        c->idx++;
+        c->off = 0;
+    }
+    return c->iov[c->idx].len - c->off;
+}
+
+// һμӽʱһδȫݣinܳΪlenoutΪlen
+static void gcm_iov_payload(sm4_gcm_ctx* ctx, const sm4_gcm_iovec* in, const sm4_gcm_iovec* out,
+    size_t len, int decrypt) {
+    uint8_t ctrs[SM4_GCM_IOV_WINDOW * 16];
+    uint8_t ks[SM4_GCM_IOV_WINDOW * 16];
+    uint8_t cbuf[SM4_GCM_IOV_WINDOW * 16];  // ڵģGHASHʹ
+    iov_cursor src = { in, 0, 0 }, dst = { out, 0, 0 };
+    const sm4_gcm_key* key = ctx->key;
+
+    gcm_begin_payload(ctx);
+    while (len > 0) {
+        // һڵĿ0ΪJ0һ飬֤ÿ
+        size_t k0 = ctx->has_ej0 ? 0 : 1;
+        size_t cap = sizeof(cbuf) - 16 * k0;
+        size_t n = len < cap ? len : cap;
+        size_t nblocks = (n + 15) / 16;
+
+        gcm_counters(ctx->J0, ctx->ctr - (uint32_t)k0, ctrs, nblocks + k0);
+        sm4_encrypt_blocks(key->rk, ctrs, ks, nblocks + k0);
+        if (k0) {
+            memcpy(ctx->EJ0, ks, 16);
+            ctx->has_ej0 = 1;
+        }
+        const uint8_t* kp = ks + 16 * k0;
+        ctx->ctr += (uint32_t)nblocks;
+
+        // Ƭбnֽڣͬʱcbuf
+        for (size_t done = 0; done < n;) {
+            size_t m = n - done;
+            size_t a = iov_avail(&src), b = iov_avail(&dst);
+            if (a < m) m = a;
+            if (b < m) m = b;
+            const uint8_t* sp = (const uint8_t*)src.iov[src.idx].base + src.off;
+            uint8_t* dp = (uint8_t*)dst.iov[dst.idx].base + dst.off;
+            uint8_t* cp = cbuf + done;
+            const uint8_t* k = kp + done;
+            if (decrypt) {
+                // ԭؽʱȱ
+                memcpy(cp, sp, m);
+                xor_bytes(dp, cp, k, m);
+            }
+            else {
+                xor_bytes(cp, sp, k, m);
+                memcpy(dp, cp, m);
+            }
+            src.off += m;
+            dst.off += m;
+            done += m;
+        }
+
+        size_t full = n / 16;
+        sm4_ghash_blocks(&key->ghash, ctx->X, cbuf, full);
+        if (n % 16 != 0) {
+            // ֻһڿܲβbufɼǩʱ0
+            ctx->buf_len = n % 16;
+            memcpy(ctx->buf, cbuf + 16 * full, ctx->buf_len);
+            memcpy(ctx->ks, kp + 16 * full, 16);
+        }
+        ctx->len_plain += n;
+        len -= n;
+    }
+}
+
+static void gcm_iov_aad(sm4_gcm_ctx* ctx, const sm4_gcm_iovec* aad, size_t aad_cnt) {
+    for (size_t i = 0; i < aad_cnt; i++) {
+        sm4_gcm_aad(ctx, (const uint8_t*)aad[i].base, aad[i].len);
+    }
+}
+
+int sm4_gcm_seal_iov(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const sm4_gcm_iovec* aad, size_t aad_cnt,
+    const sm4_gcm_iovec* in, size_t in_cnt,
+    const sm4_gcm_iovec* out, size_t out_cnt,
+    uint8_t* tag, size_t tag_len) {
+    if (iov_total(out, out_cnt) < iov_total(in, in_cnt)) {
+        return -1;
+    }
+
+    sm4_gcm_ctx ctx;
+    sm4_gcm_start(&ctx, key, iv, iv_len);
+    gcm_iov_aad(&ctx, aad, aad_cnt);
+    gcm_iov_payload(&ctx, in, out, iov_total(in, in_cnt), 0);
+    sm4_gcm_tag(&ctx, tag, tag_len);
+    return 0;
+}
+
+int sm4_gcm_open_iov(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const sm4_gcm_iovec* aad, size_t aad_cnt,
+    const sm4_gcm_iovec* in, size_t in_cnt,
+    const sm4_gcm_iovec* out, size_t out_cnt,
+    const uint8_t* tag, size_t tag_len) {
+    size_t len = iov_total(in, in_cnt);
+    if (iov_total(out, out_cnt) < len) {
+        return -1;
+    }
+
+    sm4_gcm_ctx ctx;
+    sm4_gcm_start(&ctx, key, iv, iv_len);
+    gcm_iov_aad(&ctx, aad, aad_cnt);
+    gcm_iov_payload(&ctx, in, out, len, 1);
+
+    if (sm4_gcm_verify(&ctx, tag, tag_len) != 0) {
+        // дĽܽ
+        for (size_t o = 0; o < out_cnt && len > 0; o++) {
+            size_t n = out[o].len < len ? out[o].len : len;
+            memset(out[o].base, 0, n);
+            len -= n;
+        }
+        return -1;
+    }
+    return 0;
+}
@@ -3,33 +3,183 @@
 
 #include <stdint.h>
 #include <string.h>
+#include "../sm4_AESNI-t-table/sm4.h"
 
-#define SM4_BLOCK_SIZE 16
-#define SM4_KEY_SIZE 16
-#define SM4_NUM_ROUNDS 32
+// ====== GHASH =====
+#define SM4_GHASH_POWERS 8
 
+// 汾ĬShoup 4-bit16256ֽڣ
+// ʱ SM4_GHASH_TABLE8 8-bit2564 KiB쵫ռø໺
+#ifdef SM4_GHASH_TABLE8
+#define SM4_GHASH_TABLE_BITS 8
+#else
+#define SM4_GHASH_TABLE_BITS 4
+#endif
+
+// GHASHʵ
+typedef enum {
+    SM4_GHASH_AUTO = 0,   // PCLMULQDQclmulò
+    SM4_GHASH_CLMUL,      // PCLMULQDQ8ۺ
+    SM4_GHASH_TABLE,      // Shoupݣǳʱ
+    SM4_GHASH_CTMUL,      // ʱ䣺˷ģ޽λ˷޲޷֧
+    SM4_GHASH_BITWISE,    // λ˷οʵ
+    SM4_GHASH_IMPL_COUNT
+} sm4_ghash_impl;
+
+typedef struct {
+    uint8_t H[SM4_BLOCK_SIZE];                 // ϣԿ H = E_K(0^128)
+    uint64_t Hpow[SM4_GHASH_POWERS][2];        // H^1..H^8ֽڷ򣬹PCLMULQDQʹã
+    uint64_t Hkar[SM4_GHASH_POWERS][2];        // ݸߵ64λKaratsubaм
+    uint64_t M[1 << SM4_GHASH_TABLE_BITS][2];  // Shoup M[i] = iH64λ, 64λ
+    sm4_ghash_impl impl;                       // ǰʹõʵ
+} sm4_ghash_key;
+
+// HʼԶѡʵ֣ SM4_GHASH=clmul|table|ctmul|bitwise ǿָ
+void sm4_ghash_init(sm4_ghash_key* key, const uint8_t H[SM4_BLOCK_SIZE]);
+
+// лʵֲıCPU֧ʱ-1Ҳ޸
+int sm4_ghash_set_impl(sm4_ghash_key* key, sm4_ghash_impl impl);
+
+// ʵֵƣ뻷 SM4_GHASH ȡֵͬ
+const char* sm4_ghash_impl_name(sm4_ghash_impl impl);
+
+// Ynblocks飺Y = (Y ^ X_i)H
+void sm4_ghash_blocks(const sm4_ghash_key* key, uint8_t Y[SM4_BLOCK_SIZE], const uint8_t* in, size_t nblocks);
+
+// ⳤȵݣһʱ0
+void sm4_ghash_update(const sm4_ghash_key* key, uint8_t Y[SM4_BLOCK_SIZE], const uint8_t* in, size_t len);
+
+// X = XYںϲֶμGHASH
+void sm4_ghash_mul(const sm4_ghash_key* key, uint8_t X[SM4_BLOCK_SIZE], const uint8_t Y[SM4_BLOCK_SIZE]);
+
+// out = H^n
+void sm4_ghash_pow(const sm4_ghash_key* key, uint64_t n, uint8_t out[SM4_BLOCK_SIZE]);
+
+// ====== SM4-GCM =====
+// ԿԿHԤֻһΣ֮ÿϢֻṩnonce
 typedef struct {
-    uint32_t rk[SM4_NUM_ROUNDS];  // Կ
-    uint8_t iv[SM4_BLOCK_SIZE];    // ʼ
-    uint8_t H[SM4_BLOCK_SIZE];     // ϣԿ
-    uint8_t J0[SM4_BLOCK_SIZE];    // Ԥ
+    uint32_t rk[SM4_NUM_ROUNDS];   // Կ
+    sm4_ghash_key ghash;           // ϣԿ/
+} sm4_gcm_key;
+
+void sm4_gcm_key_init(sm4_gcm_key* key, const uint8_t k[SM4_KEY_SIZE]);
+
+// ʽӿڣinit/start  aadɶΣ crypt/decrypt_updateɶΣⳤȣ tag
+// зֵõĽһԴֻͬ賣Сڴ档
+// ֻõ߱Կֵͨͣ԰ֵƣڷֲ洦״̬
+typedef struct {
+    const sm4_gcm_key* key;        // ʹõԿɵ߱
+    uint8_t J0[SM4_BLOCK_SIZE];    // Ԥ飬ǩʱʹ
+    uint8_t X[SM4_BLOCK_SIZE];     // GHASHۼֵ
+    uint32_t ctr;                  // һĵ32λ
+    uint8_t ks[SM4_BLOCK_SIZE];    // ɵһԿǰbuf_lenֽ
+    uint8_t buf[SM4_BLOCK_SIZE];   // һAADģսGHASH
+    size_t buf_len;
+    int in_payload;                // ѿʼ/ģټAAD
+    uint8_t EJ0[SM4_BLOCK_SIZE];   // E_K(J0)Ϣһʱ
+    int has_ej0;
     uint64_t len_aad;              // AAD(ֽ)
     uint64_t len_plain;            // ĳ(ֽ)
 } sm4_gcm_ctx;
 
-// ʼSM4-GCM
-void sm4_gcm_init(sm4_gcm_ctx* ctx, const uint8_t* key, const uint8_t* iv, size_t iv_len);
+// չԿʼһϢkeyϢ֮ǰЧ
+void sm4_gcm_start(sm4_gcm_ctx* ctx, const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len);
+
+// ɽӿڣԿչڲkeyctx֮ &s->ctx ʽӿڡ
+// ctx.keyָ򱾶󣬲ֵܰ
+typedef struct {
+    sm4_gcm_key key;
+    sm4_gcm_ctx ctx;
+} sm4_gcm_keyed_ctx;
+
+// ÿζչԿٿʼһϢ
+void sm4_gcm_init(sm4_gcm_keyed_ctx* s, const uint8_t* key, const uint8_t* iv, size_t iv_len);
 
-// ֤(AAD)
-void sm4_gcm_aad(sm4_gcm_ctx* ctx, const uint8_t* aad, size_t aad_len);
+// ֤(AAD)ڼӽ֮ǰ֮ٵ÷-1
+int sm4_gcm_aad(sm4_gcm_ctx* ctx, const uint8_t* aad, size_t aad_len);
 
-// /ܴ
+// ܴGHASH
 void sm4_gcm_crypt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len);
 
-// ֤ǩ
-void sm4_gcm_tag(sm4_gcm_ctx* ctx, uint8_t* tag, size_t tag_len);
+// ܴGHASHģinoutͬ
+void sm4_gcm_decrypt_update(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len);
+
+// ̰߳汾鲿֡256 KiBʱ64 KiBж̳߳ϲУεĲGHASH
+// Hݺϲ뵥̰߳汾ȫͬ߳ sm4_set_num_threads
+void sm4_gcm_crypt_mt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len);
+void sm4_gcm_decrypt_update_mt(sm4_gcm_ctx* ctx, const uint8_t* in, uint8_t* out, size_t len);
+
+// ֤ǩıctx
+void sm4_gcm_tag(const sm4_gcm_ctx* ctx, uint8_t* tag, size_t tag_len);
+
+// ʱ֤ǩtag_lenΪ1~16ͬ0򷵻-1
+int sm4_gcm_verify(const sm4_gcm_ctx* ctx, const uint8_t* tag, size_t tag_len);
+
+// һԼ/֤ʹԤչԿʺͬһԿµĴϢ
+int sm4_gcm_seal(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* plain, size_t plain_len,
+    uint8_t* cipher, uint8_t* tag, size_t tag_len);
+
+// openһɽ֤ܺcipherplainͬԭؽܣ֤ʧʱplain
+int sm4_gcm_open(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* cipher, size_t cipher_len,
+    const uint8_t* tag, size_t tag_len,
+    uint8_t* plain);
+
+// ֤ܣһֻȡļGHASHֱӴmmapļ
+// ǩȷڶٽܣ֤ʧʱ-1Ҳдplaincipherplainͬ
+int sm4_gcm_open_verify_first(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* cipher, size_t cipher_len,
+    const uint8_t* tag, size_t tag_len,
+    uint8_t* plain);
+
+// ====== Ϣ =====
+// һδĶϢ sm4_gcm_seal/open ͬ
+// keyͬϢϲͬһζ
+typedef struct {
+    const sm4_gcm_key* key;
+    const uint8_t* iv;
+    size_t iv_len;
+    const uint8_t* aad;
+    size_t aad_len;
+    const uint8_t* in;    // seal: ģopen: 
+    uint8_t* out;         // seal: ģopen: ģ֤ʧʱ㣩
+    size_t len;
+    uint8_t* tag;         // seal: ǩopen: ֤ıǩ
+    size_t tag_len;
+    int status;           // 0ɹ-1֤ʧ
+} sm4_gcm_job;
+
+void sm4_gcm_seal_batch(sm4_gcm_job* jobs, size_t njobs);
+
+// ֤ʧܵϢϢstatus
+int sm4_gcm_open_batch(sm4_gcm_job* jobs, size_t njobs);
+
+// ====== ɢ/ۼiovec=====
+// AAD롢ǲķƬбƬλΣ
+// ԿƬƬܳ費С룬򷵻-1Ƭͬ
+typedef struct {
+    void* base;
+    size_t len;
+} sm4_gcm_iovec;
+
+int sm4_gcm_seal_iov(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const sm4_gcm_iovec* aad, size_t aad_cnt,
+    const sm4_gcm_iovec* in, size_t in_cnt,
+    const sm4_gcm_iovec* out, size_t out_cnt,
+    uint8_t* tag, size_t tag_len);
+
+// ֤ʧʱ-1д
+int sm4_gcm_open_iov(const sm4_gcm_key* key, const uint8_t* iv, size_t iv_len,
+    const sm4_gcm_iovec* aad, size_t aad_cnt,
+    const sm4_gcm_iovec* in, size_t in_cnt,
+    const sm4_gcm_iovec* out, size_t out_cnt,
+    const uint8_t* tag, size_t tag_len);
 
-// ܺ
+// ܺÿչԿ
 int sm4_gcm_encrypt(
     const uint8_t* key, const uint8_t* iv, size_t iv_len,
     const uint8_t* aad, size_t aad_len,
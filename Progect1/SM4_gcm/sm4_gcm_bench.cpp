@@ -0,0 +1,306 @@
+#include "sm4_gcm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#include <sched.h>
+#endif
+
+// ====== SM4-GCM ܲ =====
+// ÿSM4ں  ÿGHASHʵ֣ seal/open ڵͰ64 B576 B1500 B
+// 16 KiB1 MiB64 MiBµܣֱ𲻴AADʹ13ֽAADTLS¼ͷ
+// cycles/byterdtscpackets/sGB/sεӳٵp50/p90/p99
+// ӳμʱpackets/sGB/sһβƵʱõõ
+// λGHASHֻǲοʵ֣Լ500 cycles/byteֻ --ghash bitwise ʱ
+// ÷: sm4_gcm_bench [--max-size BYTES] [--time MS] [--kernel NAME] [--ghash NAME] [--json FILE]
+
+enum bench_op {
+    OP_SEAL, OP_OPEN, OP_COUNT
+};
+static const char* const op_names[OP_COUNT] = { "seal", "open" };
+
+static const size_t bench_sizes[] = { 64, 576, 1500, 16 << 10, 1 << 20, 64 << 20 };
+static const size_t bench_aad_lens[] = { 0, 13 };
+
+struct bench_result {
+    const char* kernel;
+    const char* ghash;
+    const char* op;
+    size_t size;
+    size_t aad_len;
+    size_t calls;
+    double cpb;         // λ cycles/byte
+    double pps;         // õ packets/s
+    double gbps;        // õ
+    double p50_ns, p90_ns, p99_ns;
+};
+
+static void pin_to_first_cpu() {
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), 1);
+#elif defined(__linux__)
+    cpu_set_t avail;
+    if (sched_getaffinity(0, sizeof(avail), &avail) != 0) return;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &avail)) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            sched_setaffinity(0, sizeof(one), &one);
+            return;
+        }
+    }
+#endif
+}
+
+// CPUID 0x80000002~4 Ĵ
+static void cpu_brand(char brand[49]) {
+    uint32_t r[12] = { 0 };
+    for (uint32_t i = 0; i < 3; i++) {
+#if defined(_MSC_VER)
+        __cpuid((int*)&r[4 * i], (int)(0x80000002 + i));
+#else
+        __get_cpuid(0x80000002 + i, &r[4 * i], &r[4 * i + 1], &r[4 * i + 2], &r[4 * i + 3]);
+#endif
+    }
+    memcpy(brand, r, 48);
+    brand[48] = 0;
+    // ȥǰո
+    char* p = brand;
+    while (*p == ' ') p++;
+    memmove(brand, p, strlen(p) + 1);
+}
+
+// rdtscǰһlfenceõָԽʱȡǰƺִ
+static inline uint64_t rdtsc_fenced() {
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+
+// rdtscƵʣÿ̰һֻҪ룬steady_clockĿ
+// ൱Ҫ200룩ԵεֻrdtscʱٰƵʻʱ
+static double tsc_per_ns() {
+    using clock = std::chrono::steady_clock;
+    auto a = clock::now();
+    uint64_t ca = __rdtsc();
+    while (std::chrono::duration<double, std::milli>(clock::now() - a).count() < 50) {
+    }
+    uint64_t cb = __rdtsc();
+    auto b = clock::now();
+    return (double)(cb - ca) / std::chrono::duration<double, std::nano>(b - a).count();
+}
+
+struct bench_ctx {
+    sm4_gcm_key key;
+    uint8_t iv[12];
+    uint8_t aad[16];
+    uint8_t tag[16];
+    uint8_t* plain;
+    uint8_t* cipher;    // sealҲopen
+    uint8_t* out;       // opencipherֿʱ벻
+};
+
+// ׼ظʹͬһnonceֻΪÿεõĹͬʵʹв
+static int run_once(bench_ctx& c, bench_op op, size_t size, size_t aad_len) {
+    if (op == OP_SEAL) {
+        return sm4_gcm_seal(&c.key, c.iv, sizeof(c.iv), c.aad, aad_len,
+            c.plain, size, c.cipher, c.tag, sizeof(c.tag));
+    }
+    return sm4_gcm_open(&c.key, c.iv, sizeof(c.iv), c.aad, aad_len,
+        c.cipher, size, c.tag, sizeof(c.tag), c.out);
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t i = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+static bench_result measure(bench_ctx& c, bench_op op, size_t size, size_t aad_len,
+    double budget_ms, double tsc_ns) {
+    // Ԥȣ2ΣҲԤ1/10ƵʡTLBȶ״̬
+    uint64_t budget = (uint64_t)(budget_ms * 1e6 * tsc_ns);
+    uint64_t t0 = __rdtsc();
+    for (int i = 0; i < 2 || __rdtsc() - t0 < budget / 10; i++) {
+        run_once(c, op, size, aad_len);
+    }
+
+    // ӳ٣ÿεõʱһԤ㣻5ΣϢ3
+    std::vector<double> cycles;
+    size_t min_calls = size >= (16u << 20) ? 3 : 5;
+    uint64_t start = __rdtsc();
+    while (cycles.size() < min_calls || (cycles.size() < 100000 && __rdtsc() - start < budget / 2)) {
+        uint64_t ca = rdtsc_fenced();
+        run_once(c, op, size, aad_len);
+        uint64_t cb = rdtsc_fenced();
+        cycles.push_back((double)(cb - ca));
+    }
+    std::sort(cycles.begin(), cycles.end());
+
+    // £ͬĴãֻβʱμʱĿ
+    size_t calls = cycles.size();
+    uint64_t ta = rdtsc_fenced();
+    for (size_t i = 0; i < calls; i++) {
+        run_once(c, op, size, aad_len);
+    }
+    uint64_t tb = rdtsc_fenced();
+    double elapsed_ns = (double)(tb - ta) / tsc_ns;
+
+    bench_result r;
+    r.kernel = sm4_kernel_name(sm4_get_kernel());
+    r.ghash = sm4_ghash_impl_name(c.key.ghash.impl);
+    r.op = op_names[op];
+    r.size = size;
+    r.aad_len = aad_len;
+    r.calls = cycles.size();
+    r.cpb = percentile(cycles, 0.5) / (double)size;
+    r.p50_ns = percentile(cycles, 0.5) / tsc_ns;
+    r.p90_ns = percentile(cycles, 0.9) / tsc_ns;
+    r.p99_ns = percentile(cycles, 0.99) / tsc_ns;
+    r.pps = (double)calls * 1e9 / elapsed_ns;
+    r.gbps = (double)calls * (double)size / elapsed_ns;
+    return r;
+}
+
+// JSONַţתšбܺͿַ
+static void json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') {
+            fprintf(f, "\\%c", ch);
+        }
+        else if (ch < 0x20) {
+            fprintf(f, "\\u%04x", ch);
+        }
+        else {
+            fputc(ch, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void write_json(FILE* f, const char* cpu, double tsc_ns, const std::vector<bench_result>& results) {
+    fprintf(f, "{\n  \"cpu\": ");
+    json_string(f, cpu);
+    fprintf(f, ",\n  \"tsc_ghz\": %.3f,\n  \"results\": [\n", tsc_ns);
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result& r = results[i];
+        fprintf(f, "    {\"kernel\": \"%s\", \"ghash\": \"%s\", \"op\": \"%s\", \"size\": %zu, \"aad\": %zu, "
+            "\"calls\": %zu, \"cycles_per_byte\": %.3f, \"packets_per_s\": %.0f, \"gb_per_s\": %.4f, "
+            "\"latency_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f}}%s\n",
+            r.kernel, r.ghash, r.op, r.size, r.aad_len, r.calls, r.cpb, r.pps, r.gbps,
+            r.p50_ns, r.p90_ns, r.p99_ns, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    size_t max_size = 64u << 20;
+    double budget_ms = 100;
+    const char* kernel_filter = NULL;
+    const char* ghash_filter = NULL;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            max_size = (size_t)strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            budget_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            kernel_filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--ghash") == 0 && i + 1 < argc) {
+            ghash_filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        }
+        else {
+            fprintf(stderr, "usage: %s [--max-size BYTES] [--time MS] [--kernel NAME] [--ghash NAME] [--json FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    pin_to_first_cpu();
+    sm4_init();
+    double tsc_ns = tsc_per_ns();
+
+    bench_ctx c;
+    uint8_t key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uint8_t)(i * 37 + 1);
+    for (int i = 0; i < 12; i++) c.iv[i] = (uint8_t)(i * 11 + 5);
+    for (int i = 0; i < 16; i++) c.aad[i] = (uint8_t)(i + 0x17);
+    sm4_gcm_key_init(&c.key, key);
+
+    size_t buf_size = 0;
+    for (size_t s : bench_sizes) {
+        if (s <= max_size) buf_size = s;
+    }
+    std::vector<uint8_t> plain(buf_size), cipher(buf_size), out(buf_size);
+    for (size_t i = 0; i < buf_size; i++) plain[i] = (uint8_t)(i * 31 + 7);
+    c.plain = plain.data();
+    c.cipher = cipher.data();
+    c.out = out.data();
+
+    char cpu[49];
+    cpu_brand(cpu);
+    printf("CPU: %s, TSC %.3f GHz\n", cpu, tsc_ns);
+    printf("%-8s %-7s %-4s %9s %4s %9s %12s %8s %10s %10s %10s\n",
+        "kernel", "ghash", "op", "size", "aad", "cyc/byte", "packets/s", "GB/s", "p50 ns", "p90 ns", "p99 ns");
+
+    std::vector<bench_result> results;
+    sm4_kernel selected = sm4_get_kernel();
+    for (int k = 0; k < SM4_KERNEL_COUNT; k++) {
+        if (kernel_filter && strcmp(kernel_filter, sm4_kernel_name((sm4_kernel)k)) != 0) continue;
+        if (sm4_set_kernel((sm4_kernel)k) != 0) continue;
+        for (int g = SM4_GHASH_AUTO + 1; g < SM4_GHASH_IMPL_COUNT; g++) {
+            if (ghash_filter ? strcmp(ghash_filter, sm4_ghash_impl_name((sm4_ghash_impl)g)) != 0
+                : g == SM4_GHASH_BITWISE) continue;
+            if (sm4_ghash_set_impl(&c.key.ghash, (sm4_ghash_impl)g) != 0) continue;
+            for (size_t size : bench_sizes) {
+                if (size > max_size) continue;
+                for (size_t aad_len : bench_aad_lens) {
+                    // openҪ뵱ǰȺAADƥĺͱǩ
+                    run_once(c, OP_SEAL, size, aad_len);
+                    if (run_once(c, OP_OPEN, size, aad_len) != 0) {
+                        fprintf(stderr, "open failed: kernel %s, ghash %s, size %zu\n",
+                            sm4_kernel_name((sm4_kernel)k), sm4_ghash_impl_name((sm4_ghash_impl)g), size);
+                        return 1;
+                    }
+                    for (int op = 0; op < OP_COUNT; op++) {
+                        bench_result r = measure(c, (bench_op)op, size, aad_len, budget_ms, tsc_ns);
+                        printf("%-8s %-7s %-4s %9zu %4zu %9.2f %12.0f %8.3f %10.0f %10.0f %10.0f\n",
+                            r.kernel, r.ghash, r.op, r.size, r.aad_len, r.cpb, r.pps, r.gbps,
+                            r.p50_ns, r.p90_ns, r.p99_ns);
+                        fflush(stdout);
+                        results.push_back(r);
+                    }
+                }
+            }
+        }
+    }
+    sm4_set_kernel(selected);
+
+    if (json_path) {
+        FILE* f = fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot open %s\n", json_path);
+            return 1;
+        }
+        write_json(f, cpu, tsc_ns, results);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include "sm4.h"
+#include <stdio.h>
+#include <string.h>
+
+// ӡһ
+static void print_block(const char* label, const uint8_t* data) {
+    printf("%s", label);
+    for (int i = 0; i < 16; i++) printf("%02x ", data[i]);
+    printf("\n");
+}
+
+// ģʽ֪𰸣Ϊmainе37ݣֻĵ32ֽ
+// CBC/OFB/CFBһXTSÿβ16ֽڡ
+// OpenSSLsm4-cbc/ctr/ofb/cfbͻsm4-ecbĶIEEE 1619ʵ
+static const uint8_t kat_cbc[32] = {
+    0x7a,0xef,0xe8,0xc3,0x9d,0xe6,0x31,0x66,0x73,0xaf,0x70,0xa1,0x46,0xf8,0xc8,0xaa,
+    0xdc,0xe9,0xd7,0xf6,0xd5,0xb5,0x96,0xa7,0x69,0x8f,0x89,0x62,0x01,0xfd,0x76,0x47,
+};
+static const uint8_t kat_ctr[32] = {
+    0x97,0xf0,0x3b,0xb4,0xb0,0x61,0x6f,0x4f,0x7a,0x79,0xc9,0x0c,0x99,0x2d,0x49,0xff,
+    0xcb,0xa5,0xa0,0xb3,0x2b,0xbd,0x4a,0xca,0x91,0x5d,0xf4,0xbb,0x41,0x06,0xbb,0x5e,
+};
+static const uint8_t kat_ofb[32] = {
+    0xc4,0xf4,0x13,0x33,0x99,0xff,0xfa,0xf3,0x89,0x63,0x4b,0xd3,0x72,0x77,0x35,0x86,
+    0xee,0x86,0x1e,0xa7,0x26,0xce,0x24,0xe6,0xf6,0x71,0xc5,0xf1,0x57,0x05,0x05,0x81,
+};
+static const uint8_t kat_cfb[32] = {
+    0x16,0x5b,0x02,0xb8,0xe2,0x70,0x6c,0xf0,0x80,0xcc,0xd1,0x11,0x7d,0x34,0xd3,0x04,
+    0xc3,0xaf,0xb4,0xe1,0xfd,0xb0,0x10,0xf6,0x06,0x70,0xf4,0x2a,0xe8,0x80,0xda,0xb9,
+};
+// 587ֽڣȡ
+static const uint8_t kat_xts[32] = {
+    0x17,0xeb,0x11,0x14,0x3f,0xc1,0x5c,0xb7,0x79,0x8a,0x00,0xf9,0x52,0xf9,0xa6,0xfd,
+    0xf0,0xd6,0x70,0xff,0x6d,0xd1,0xa8,0x8d,0xd8,0x48,0xfb,0x9e,0xc5,0xfc,0x07,0x97,
+};
+// 1001014096ֽڣ
+static const uint8_t kat_xts_sectors[64] = {
+    0x24,0xb2,0xd5,0x52,0xeb,0x37,0x84,0x02,0x0c,0x1a,0xab,0x26,0xfc,0x39,0x3d,0x29,
+    0x69,0xc9,0x68,0x4f,0xcd,0xd6,0xc5,0xdf,0x66,0x18,0x17,0x20,0x28,0x58,0xd2,0x5d,
+    0x39,0x5d,0xbb,0x9c,0x6d,0xbf,0x11,0x5e,0x1d,0x37,0x0c,0xbf,0x35,0x68,0x2e,0x8f,
+    0x7d,0x20,0x17,0x98,0x6e,0xb6,0x22,0x63,0x3a,0x53,0xbd,0xfe,0x5f,0xa3,0xd3,0x2b,
+};
+
+// ǶײУÿٵ sm4_parallel_for  sm4_ctr_crypt_mtӦִж
+struct nested_job {
+    const uint32_t* rk;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t seg_len;
+    unsigned hits[8][16];
+};
+
+static void nested_inner(void* arg, size_t begin, size_t end) {
+    unsigned* hits = (unsigned*)arg;
+    for (size_t i = begin; i < end; i++) hits[i]++;
+}
+
+static void nested_outer(void* arg, size_t begin, size_t end) {
+    nested_job* job = (nested_job*)arg;
+    for (size_t i = begin; i < end; i++) {
+        sm4_parallel_for(16, 1, nested_inner, job->hits[i]);
+        uint8_t ctr[16] = { 0 };
+        ctr[15] = (uint8_t)i;
+        sm4_ctr_crypt_mt(job->rk, ctr, job->in + i * job->seg_len, job->out + i * job->seg_len, job->seg_len);
+    }
+}
+
+int main() {
+    // οSM4׼ʾ
+    uint8_t key[16] = {
+        0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
+        0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10
+    };
+    uint8_t plaintext[16] = {
+        0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
+        0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10
+    };
+    uint8_t ciphertext[16];
+    uint32_t rk[32];
+
+    sm4_init();
+    sm4_key_schedule(key, rk);
+
+    printf("=== T-table 汾ܽ ===\n");
+    sm4_encrypt_block(plaintext, ciphertext, rk);
+    print_block("", ciphertext);
+
+    printf("=== ʱ: %s ===\n", sm4_kernel_name(sm4_get_kernel()));
+    sm4_encrypt_blocks(rk, plaintext, ciphertext, 1);
+    print_block("", ciphertext);
+
+    // 37 = 216 + 5βǸں˵β·
+    const int nblocks = 37;
+    uint8_t in[37][16];
+    uint8_t out[37][16];
+    uint8_t ref[37][16];
+    for (int i = 0; i < nblocks; i++) {
+        for (int j = 0; j < 16; j++) {
+            in[i][j] = (uint8_t)(plaintext[j] ^ (i * 7 + j));
+        }
+        sm4_encrypt_block(in[i], ref[i], rk);
+    }
+
+    sm4_kernel selected = sm4_get_kernel();
+    for (int k = 0; k < SM4_KERNEL_COUNT; k++) {
+        if (sm4_set_kernel((sm4_kernel)k) != 0) {
+            printf("%-8s: not supported on this CPU\n", sm4_kernel_name((sm4_kernel)k));
+            continue;
+        }
+        memset(out, 0, sizeof(out));
+        sm4_encrypt_blocks(rk, &in[0][0], &out[0][0], nblocks);
+        int ok = memcmp(out, ref, sizeof(ref)) == 0;
+        printf("%-8s: %s\n", sm4_kernel_name((sm4_kernel)k), ok ? "matches T-table" : "ERROR: mismatch");
+    }
+    sm4_set_kernel(selected);
+
+    printf("===  ===\n");
+    uint32_t rk_dec[32];
+    uint8_t decrypted[16];
+    sm4_key_schedule_dec(key, rk_dec);
+    sm4_encrypt_block(plaintext, ciphertext, rk);
+    sm4_decrypt_block(ciphertext, decrypted, rk_dec);
+    print_block("", decrypted);
+
+    // ģʽܺٽܣCBC/CFBԭؽܣӦԭ
+    printf("=== ģʽ ===\n");
+    const uint8_t iv0[16] = {
+        0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+        0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f
+    };
+    uint8_t iv[16];
+    uint8_t buf[37][16];
+    const size_t len = sizeof(in);
+    const size_t odd_len = len - 5;  // ģʽԲһβ
+
+    sm4_ecb_encrypt(rk, &in[0][0], &buf[0][0], len);
+    sm4_ecb_decrypt(rk_dec, &buf[0][0], &buf[0][0], len);
+    printf("ECB: %s\n", memcmp(buf, in, len) == 0 ? "ok" : "ERROR");
+
+    memcpy(iv, iv0, 16);
+    sm4_cbc_encrypt(rk, iv, &in[0][0], &buf[0][0], len);
+    memcpy(iv, iv0, 16);
+    sm4_cbc_decrypt(rk_dec, iv, &buf[0][0], &buf[0][0], len);
+    printf("CBC: %s\n", memcmp(buf, in, len) == 0 ? "ok" : "ERROR");
+
+    memcpy(iv, iv0, 16);
+    sm4_ctr_crypt(rk, iv, &in[0][0], &buf[0][0], odd_len);
+    memcpy(iv, iv0, 16);
+    sm4_ctr_crypt(rk, iv, &buf[0][0], &buf[0][0], odd_len);
+    printf("CTR: %s\n", memcmp(buf, in, odd_len) == 0 ? "ok" : "ERROR");
+
+    memcpy(iv, iv0, 16);
+    sm4_ofb_crypt(rk, iv, &in[0][0], &buf[0][0], odd_len);
+    memcpy(iv, iv0, 16);
+    sm4_ofb_crypt(rk, iv, &buf[0][0], &buf[0][0], odd_len);
+    printf("OFB: %s\n", memcmp(buf, in, odd_len) == 0 ? "ok" : "ERROR");
+
+    memcpy(iv, iv0, 16);
+    sm4_cfb_encrypt(rk, iv, &in[0][0], &buf[0][0], odd_len);
+    memcpy(iv, iv0, 16);
+    sm4_cfb_decrypt(rk, iv, &buf[0][0], &buf[0][0], odd_len);
+    printf("CFB: %s\n", memcmp(buf, in, odd_len) == 0 ? "ok" : "ERROR");
+
+    // XTS4 KiBӽܣٲԴȡĵݵԪ
+    printf("=== XTS ===\n");
+    uint8_t xts_k[32];
+    for (int i = 0; i < 32; i++) xts_k[i] = (uint8_t)(i * 0x11 + 1);
+    sm4_xts_key xkey;
+    sm4_xts_set_key(&xkey, xts_k);
+
+    static uint8_t sectors[2][4096], sectors_out[2][4096];
+    for (int i = 0; i < 2 * 4096; i++) (&sectors[0][0])[i] = (uint8_t)(i * 31 + 7);
+    sm4_xts_encrypt_sectors(&xkey, 100, 4096, &sectors[0][0], &sectors_out[0][0], 2);
+    sm4_xts_decrypt_sectors(&xkey, 100, 4096, &sectors_out[0][0], &sectors_out[0][0], 2);
+    printf("XTS sectors: %s\n", memcmp(sectors, sectors_out, sizeof(sectors)) == 0 ? "ok" : "ERROR");
+
+    sm4_xts_encrypt(&xkey, iv0, &in[0][0], &buf[0][0], odd_len);
+    sm4_xts_decrypt(&xkey, iv0, &buf[0][0], &buf[0][0], odd_len);
+    printf("XTS stealing: %s\n", memcmp(buf, in, odd_len) == 0 ? "ok" : "ERROR");
+
+    // ģʽοʵֵĶԱȣÿں˶һ
+    printf("=== ģʽ֪ ===\n");
+    selected = sm4_get_kernel();
+    for (int k = 0; k < SM4_KERNEL_COUNT; k++) {
+        if (sm4_set_kernel((sm4_kernel)k) != 0) continue;
+        const char* bad[6];
+        int nbad = 0;
+
+        memcpy(iv, iv0, 16);
+        sm4_cbc_encrypt(rk, iv, &in[0][0], &buf[0][0], len);
+        if (memcmp(&buf[0][0] + len - 32, kat_cbc, 32) != 0) bad[nbad++] = "CBC";
+
+        memcpy(iv, iv0, 16);
+        sm4_ctr_crypt(rk, iv, &in[0][0], &buf[0][0], odd_len);
+        if (memcmp(&buf[0][0] + odd_len - 32, kat_ctr, 32) != 0) bad[nbad++] = "CTR";
+
+        memcpy(iv, iv0, 16);
+        sm4_ofb_crypt(rk, iv, &in[0][0], &buf[0][0], odd_len);
+        if (memcmp(&buf[0][0] + odd_len - 32, kat_ofb, 32) != 0) bad[nbad++] = "OFB";
+
+        memcpy(iv, iv0, 16);
+        sm4_cfb_encrypt(rk, iv, &in[0][0], &buf[0][0], odd_len);
+        if (memcmp(&buf[0][0] + odd_len - 32, kat_cfb, 32) != 0) bad[nbad++] = "CFB";
+
+        sm4_xts_encrypt(&xkey, iv0, &in[0][0], &buf[0][0], odd_len);
+        if (memcmp(&buf[0][0] + odd_len - 32, kat_xts, 32) != 0) bad[nbad++] = "XTS stealing";
+
+        sm4_xts_encrypt_sectors(&xkey, 100, 4096, &sectors[0][0], &sectors_out[0][0], 2);
+        int sec_ok = 1;
+        for (int i = 0; i < 2; i++) {
+            sec_ok &= memcmp(sectors_out[i], kat_xts_sectors + 32 * i, 16) == 0;
+            sec_ok &= memcmp(sectors_out[i] + 4096 - 16, kat_xts_sectors + 32 * i + 16, 16) == 0;
+        }
+        if (!sec_ok) bad[nbad++] = "XTS sectors";
+
+        printf("%-8s: ", sm4_kernel_name((sm4_kernel)k));
+        if (nbad == 0) {
+            printf("CBC/CTR/OFB/CFB/XTS match reference vectors\n");
+        }
+        else {
+            printf("ERROR:");
+            for (int i = 0; i < nbad; i++) printf(" %s", bad[i]);
+            printf("\n");
+        }
+    }
+    sm4_set_kernel(selected);
+
+    // ߳CTR뵥߳̽Աȣ64λӽμλ
+    printf("=== ߳CTR (%d threads) ===\n", sm4_get_num_threads());
+    const size_t big_len = 4 * 1024 * 1024 + 5;
+    static uint8_t big_in[4 * 1024 * 1024 + 5], big_ref[4 * 1024 * 1024 + 5], big_out[4 * 1024 * 1024 + 5];
+    for (size_t i = 0; i < big_len; i++) big_in[i] = (uint8_t)(i * 13);
+    uint8_t ctr_a[16], ctr_b[16];
+    memset(ctr_a, 0xff, 16);
+    ctr_a[0] = 0;
+    memcpy(ctr_b, ctr_a, 16);
+    sm4_ctr_crypt(rk, ctr_a, big_in, big_ref, big_len);
+    sm4_ctr_crypt_mt(rk, ctr_b, big_in, big_out, big_len);
+    int same = memcmp(big_ref, big_out, big_len) == 0 && memcmp(ctr_a, ctr_b, 16) == 0;
+    printf("CTR-MT: %s\n", same ? "matches sequential" : "ERROR");
+
+    int saved_threads = sm4_get_num_threads();
+    sm4_set_num_threads(4);
+    static nested_job nj;
+    nj.rk = rk;
+    nj.in = big_in;
+    nj.out = big_out;
+    nj.seg_len = big_len / 8;
+    memset(nj.hits, 0, sizeof(nj.hits));
+    sm4_parallel_for(8, 1, nested_outer, &nj);
+    int nested_ok = 1;
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 16; j++) nested_ok &= nj.hits[i][j] == 1;
+        uint8_t ctr[16] = { 0 };
+        ctr[15] = (uint8_t)i;
+        sm4_ctr_crypt(rk, ctr, big_in + i * nj.seg_len, big_ref, nj.seg_len);
+        nested_ok &= memcmp(big_ref, big_out + i * nj.seg_len, nj.seg_len) == 0;
+    }
+    printf("nested parallel_for (4 threads): %s\n", nested_ok ? "ok" : "ERROR");
+    sm4_set_num_threads(saved_threads);
+
+    // ԿչչԱ
+    printf("=== Կչ ===\n");
+    uint8_t many_keys[20][16];
+    uint32_t many_rk[20][32], one_rk[32];
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 16; j++) many_keys[i][j] = (uint8_t)(key[j] + i * 3 + j);
+    }
+    sm4_key_schedule_multi(&many_keys[0][0], 20, many_rk);
+    int keys_ok = 1;
+    for (int i = 0; i < 20; i++) {
+        sm4_key_schedule(many_keys[i], one_rk);
+        keys_ok &= memcmp(one_rk, many_rk[i], sizeof(one_rk)) == 0;
+    }
+    printf("key schedule x20 (%s): %s\n", sm4_kernel_name(sm4_get_kernel()), keys_ok ? "ok" : "ERROR");
+
+    return 0;
+}
@@ -1,8 +1,7 @@
-#include <stdio.h>
-#include <stdint.h>
+#include "sm4.h"
 
 // --- S ---
-static const uint8_t Sbox[256] = {
+static constexpr uint8_t Sbox[256] = {
     0xd6,0x90,0xe9,0xfe,0xcc,0xe1,0x3d,0xb7,0x16,0xb6,0x14,0xc2,0x28,0xfb,0x2c,0x05,
     0x2b,0x67,0x9a,0x76,0x2a,0xbe,0x04,0xc3,0xaa,0x44,0x13,0x26,0x49,0x86,0x06,0x99,
     0x9c,0x42,0x50,0xf4,0x91,0xef,0x98,0x7a,0x33,0x54,0x0b,0x43,0xed,0xcf,0xac,0x62,
@@ -21,9 +20,9 @@ static const uint8_t Sbox[256] = {
     0x18,0xf0,0x7d,0xec,0x3a,0xdc,0x4d,0x20,0x79,0xee,0x5f,0x3e,0xd7,0xcb,0x39,0x48,
 };
 
-// ԿFKCK
-static const uint32_t FK[4] = { 0xa3b1bac6,0x56aa3350,0x677d9197,0xb27022dc };
-static const uint32_t CK[32] = {
+// ԿFKCKԿչҲʹ
+const uint32_t sm4_FK[4] = { 0xa3b1bac6,0x56aa3350,0x677d9197,0xb27022dc };
+const uint32_t sm4_CK[32] = {
     0x00070e15,0x1c232a31,0x383f464d,0x545b6269,
     0x70777e85,0x8c939aa1,0xa8afb6bd,0xc4cbd2d9,
     0xe0e7eef5,0xfc030a11,0x181f262d,0x343b4249,
@@ -35,39 +34,68 @@ static const uint32_t CK[32] = {
 };
 
 // ѭƺ
-static uint32_t rol(uint32_t x, int n) {
+static constexpr uint32_t rol(uint32_t x, int n) {
     return (x << n) | (x >> (32 - n));
 }
 
 // Ա任L
-static uint32_t L(uint32_t b) {
+static constexpr uint32_t L(uint32_t b) {
     return b ^ rol(b, 2) ^ rol(b, 10) ^ rol(b, 18) ^ rol(b, 24);
 }
 
-// 4T-table
-static uint32_t T0[256];
-static uint32_t T1[256];
-static uint32_t T2[256];
-static uint32_t T3[256];
+// ====== T-table =====
+// ڱSboxLɣֻʼ
+// TiӦֵĵiֽڣˣSŵֽλúL
+// LѭλɽTi[x] = T0[x] >>> 8i SM4_COMPACT_TTABLE ʱ
+// ֻT0(1 KiB)űλõL1ռô4 KiB1 KiB
+#ifdef SM4_COMPACT_TTABLE
+#define SM4_TTABLE_COUNT 1
+#else
+#define SM4_TTABLE_COUNT 4
+#endif
 
-// ʼT-table
-void init_t_tables() {
+struct sm4_ttables {
+    uint32_t T[SM4_TTABLE_COUNT][256];
+};
+
+static constexpr sm4_ttables make_t_tables() {
+    sm4_ttables t = {};
     for (int i = 0; i < 256; i++) {
         uint32_t s = Sbox[i];
-        uint32_t b = (s << 24) | (s << 16) | (s << 8) | s;  // 4ֽͬ
-        T0[i] = L(b);
-        T1[i] = L((b << 8) | (b >> 24));
-        T2[i] = L((b << 16) | (b >> 16));
-        T3[i] = L((b << 24) | (b >> 8));
+        for (int j = 0; j < SM4_TTABLE_COUNT; j++) {
+            t.T[j][i] = L(s << (24 - 8 * j));
+        }
     }
+    return t;
 }
 
+alignas(64) static constexpr sm4_ttables TT = make_t_tables();
+
 // T-tableT
-static uint32_t sm4_t_table(uint32_t a) {
-    return T0[(a >> 24) & 0xFF] ^
-        T1[(a >> 16) & 0xFF] ^
-        T2[(a >> 8) & 0xFF] ^
-        T3[a & 0xFF];
+static inline uint32_t sm4_t_table(uint32_t a) {
+#ifdef SM4_COMPACT_TTABLE
+    return TT.T[0][(a >> 24) & 0xFF] ^
+        rol(TT.T[0][(a >> 16) & 0xFF], 24) ^
+        rol(TT.T[0][(a >> 8) & 0xFF], 16) ^
+        rol(TT.T[0][a & 0xFF], 8);
+#else
+    return TT.T[0][(a >> 24) & 0xFF] ^
+        TT.T[1][(a >> 16) & 0xFF] ^
+        TT.T[2][(a >> 8) & 0xFF] ^
+        TT.T[3][a & 0xFF];
+#endif
+}
+
+// Լ죺T0[0] = L(S(0) << 24)
+static_assert(TT.T[0][0] == L(0xd6u << 24), "SM4 T-table generation");
+
+// ԿչõT'任S + L'(B) = B ^ (B <<< 13) ^ (B <<< 23)
+static uint32_t sm4_key_t(uint32_t a) {
+    uint32_t b = ((uint32_t)Sbox[(a >> 24) & 0xFF] << 24) |
+        ((uint32_t)Sbox[(a >> 16) & 0xFF] << 16) |
+        ((uint32_t)Sbox[(a >> 8) & 0xFF] << 8) |
+        Sbox[a & 0xFF];
+    return b ^ rol(b, 13) ^ rol(b, 23);
 }
 
 // Կչ
@@ -75,15 +103,24 @@ void sm4_key_schedule(const uint8_t key[16], uint32_t rk[32]) {
     uint32_t K[36];
     for (int i = 0; i < 4; i++) {
         K[i] = ((uint32_t)key[4 * i] << 24) | ((uint32_t)key[4 * i + 1] << 16) | ((uint32_t)key[4 * i + 2] << 8) | key[4 * i + 3];
-        K[i] ^= FK[i];
+        K[i] ^= sm4_FK[i];
     }
     for (int i = 0; i < 32; i++) {
-        uint32_t tmp = K[i + 1] ^ K[i + 2] ^ K[i + 3] ^ CK[i];
-        K[i + 4] = K[i] ^ sm4_t_table(tmp);
+        uint32_t tmp = K[i + 1] ^ K[i + 2] ^ K[i + 3] ^ sm4_CK[i];
+        K[i + 4] = K[i] ^ sm4_key_t(tmp);
         rk[i] = K[i + 4];
     }
 }
 
+// ԿԿ
+void sm4_key_schedule_dec(const uint8_t key[16], uint32_t rk_dec[32]) {
+    uint32_t rk[32];
+    sm4_key_schedule(key, rk);
+    for (int i = 0; i < 32; i++) {
+        rk_dec[i] = rk[31 - i];
+    }
+}
+
 // 
 void sm4_encrypt_block(const uint8_t in[16], uint8_t out[16], const uint32_t rk[32]) {
     uint32_t X[36];
@@ -103,28 +140,14 @@ void sm4_encrypt_block(const uint8_t in[16], uint8_t out[16], const uint32_t rk[
     }
 }
 
-int main() {
-    // οSM4׼ʾ
-    uint8_t key[16] = {
-        0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
-        0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10
-    };
-    uint8_t plaintext[16] = {
-        0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
-        0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10
-    };
-    uint8_t ciphertext[16];
-    uint32_t rk[32];
-
-    init_t_tables();
-    sm4_key_schedule(key, rk);
-    sm4_encrypt_block(plaintext, ciphertext, rk);
+// ܣṹͬʹ÷Կ
+void sm4_decrypt_block(const uint8_t in[16], uint8_t out[16], const uint32_t rk_dec[32]) {
+    sm4_encrypt_block(in, out, rk_dec);
+}
 
-    printf("SM4 ciphertext:\n");
-    for (int i = 0; i < 16; i++) {
-        printf("%02x ", ciphertext[i]);
+// ܣT-table汾鴦
+void sm4_encrypt_blocks_ttable(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    for (size_t i = 0; i < nblocks; i++) {
+        sm4_encrypt_block(in + 16 * i, out + 16 * i, rk);
     }
-    printf("\n");
-
-    return 0;
 }
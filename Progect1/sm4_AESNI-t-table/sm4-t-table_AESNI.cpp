@@ -1,121 +1,61 @@
-#include <stdio.h>
-#include <stdint.h>
+#include "sm4.h"
 #include <immintrin.h>  // AVX2
 #include <wmmintrin.h>  // AES-NI
-
-// --- S ---
-static const uint8_t Sbox[256] = {
-    0xd6,0x90,0xe9,0xfe,0xcc,0xe1,0x3d,0xb7,0x16,0xb6,0x14,0xc2,0x28,0xfb,0x2c,0x05,
-    0x2b,0x67,0x9a,0x76,0x2a,0xbe,0x04,0xc3,0xaa,0x44,0x13,0x26,0x49,0x86,0x06,0x99,
-    0x9c,0x42,0x50,0xf4,0x91,0xef,0x98,0x7a,0x33,0x54,0x0b,0x43,0xed,0xcf,0xac,0x62,
-    0xe4,0xb3,0x1c,0xa9,0xc9,0x08,0xe8,0x95,0x80,0xdf,0x94,0xfa,0x75,0x8f,0x3f,0xa6,
-    0x47,0x07,0xa7,0xfc,0xf3,0x73,0x17,0xba,0x83,0x59,0x3c,0x19,0xe6,0x85,0x4f,0xa8,
-    0x68,0x6b,0x81,0xb2,0x71,0x64,0xda,0x8b,0xf8,0xeb,0x0f,0x4b,0x70,0x56,0x9d,0x35,
-    0x1e,0x24,0x0e,0x5e,0x63,0x58,0xd1,0xa2,0x25,0x22,0x7c,0x3b,0x01,0x21,0x78,0x87,
-    0xd4,0x00,0x46,0x57,0x9f,0xd3,0x27,0x52,0x4c,0x36,0x02,0xe7,0xa0,0xc4,0xc8,0x9e,
-    0xea,0xbf,0x8a,0xd2,0x40,0xc7,0x38,0xb5,0xa3,0xf7,0xf2,0xce,0xf9,0x61,0x15,0xa1,
-    0xe0,0xae,0x5d,0xa4,0x9b,0x34,0x1a,0x55,0xad,0x93,0x32,0x30,0xf5,0x8c,0xb1,0xe3,
-    0x1d,0xf6,0xe2,0x2e,0x82,0x66,0xca,0x60,0xc0,0x29,0x23,0xab,0x0d,0x53,0x4e,0x6f,
-    0xd5,0xdb,0x37,0x45,0xde,0xfd,0x8e,0x2f,0x03,0xff,0x6a,0x72,0x6d,0x6c,0x5b,0x51,
-    0x8d,0x1b,0xaf,0x92,0xbb,0xdd,0xbc,0x7f,0x11,0xd9,0x5c,0x41,0x1f,0x10,0x5a,0xd8,
-    0x0a,0xc1,0x31,0x88,0xa5,0xcd,0x7b,0xbd,0x2d,0x74,0xd0,0x12,0xb8,0xe5,0xb4,0xb0,
-    0x89,0x69,0x97,0x4a,0x0c,0x96,0x77,0x7e,0x65,0xb9,0xf1,0x09,0xc5,0x6e,0xc6,0x84,
-    0x18,0xf0,0x7d,0xec,0x3a,0xdc,0x4d,0x20,0x79,0xee,0x5f,0x3e,0xd7,0xcb,0x39,0x48,
-};
-
-// ԿFKCK
-static const uint32_t FK[4] = { 0xa3b1bac6,0x56aa3350,0x677d9197,0xb27022dc };
-static const uint32_t CK[32] = {
-    0x00070e15,0x1c232a31,0x383f464d,0x545b6269,
-    0x70777e85,0x8c939aa1,0xa8afb6bd,0xc4cbd2d9,
-    0xe0e7eef5,0xfc030a11,0x181f262d,0x343b4249,
-    0x50575e65,0x6c737a81,0x888f969d,0xa4abb2b9,
-    0xc0c7ced5,0xdce3eaf1,0xf8ff060d,0x141b2229,
-    0x30373e45,0x4c535a61,0x686f767d,0x848b9299,
-    0xa0a7aeb5,0xbcc3cad1,0xd8dfe6ed,0xf4fb0209,
-    0x10171e25,0x2c333a41,0x484f565d,0x646b7279
-};
+#include <string.h>
 
 // ѭƺ
 static uint32_t rol(uint32_t x, int n) {
     return (x << n) | (x >> (32 - n));
 }
 
-// Ա任L
-static uint32_t L(uint32_t b) {
-    return b ^ rol(b, 2) ^ rol(b, 10) ^ rol(b, 18) ^ rol(b, 24);
+// ====== AES-NI ٵ Sб任 =====
+// SM4AESSж "GF(2^8) + 任"ֻõĲԼʽͬ(0x1F5 / 0x11B)
+// ͬ S_sm4(x) = Post(AES_S(Pre(x)))Pre/PostΪGF(2)ϵķ任
+// 任ߵ4bit𿪣pshufb16СɣAES_S _mm_aesenclast_si128 㡣
+
+// PreSM4 -> AES򣨺SM4 A*x+C
+static inline __m128i sm4_pre_lo() {
+    return _mm_setr_epi8(0x3e, (char)0xb2, 0x0e, (char)0x82, (char)0xbb, 0x37, (char)0x8b, 0x07,
+        (char)0xa1, 0x2d, (char)0x91, 0x1d, 0x24, (char)0xa8, 0x14, (char)0x98);
 }
-
-// 4T-table
-static uint32_t T0[256];
-static uint32_t T1[256];
-static uint32_t T2[256];
-static uint32_t T3[256];
-
-// ʼT-table
-void init_t_tables() {
-    for (int i = 0; i < 256; i++) {
-        uint32_t s = Sbox[i];
-        uint32_t b = (s << 24) | (s << 16) | (s << 8) | s;  // 4ֽͬ
-        T0[i] = L(b);
-        T1[i] = L((b << 8) | (b >> 24));
-        T2[i] = L((b << 16) | (b >> 16));
-        T3[i] = L((b << 24) | (b >> 8));
-    }
+static inline __m128i sm4_pre_hi() {
+    return _mm_setr_epi8(0x00, (char)0xdc, 0x2e, (char)0xf2, (char)0xc5, 0x19, (char)0xeb, 0x37,
+        0x08, (char)0xd4, 0x26, (char)0xfa, (char)0xcd, 0x11, (char)0xe3, 0x3f);
 }
-
-// T-tableT
-static uint32_t sm4_t_table(uint32_t a) {
-    return T0[(a >> 24) & 0xFF] ^
-        T1[(a >> 16) & 0xFF] ^
-        T2[(a >> 8) & 0xFF] ^
-        T3[a & 0xFF];
+// PostȥAES䣬ӳSM4SM4
+static inline __m128i sm4_post_lo() {
+    return _mm_setr_epi8(0x6c, (char)0xd4, (char)0xa6, 0x1e, 0x52, (char)0xea, (char)0x98, 0x20,
+        0x0b, (char)0xb3, (char)0xc1, 0x79, 0x35, (char)0x8d, (char)0xff, 0x47);
 }
-
-// Կչ
-void sm4_key_schedule(const uint8_t key[16], uint32_t rk[32]) {
-    uint32_t K[36];
-    for (int i = 0; i < 4; i++) {
-        K[i] = ((uint32_t)key[4 * i] << 24) | ((uint32_t)key[4 * i + 1] << 16) |
-            ((uint32_t)key[4 * i + 2] << 8) | key[4 * i + 3];
-        K[i] ^= FK[i];
-    }
-    for (int i = 0; i < 32; i++) {
-        uint32_t tmp = K[i + 1] ^ K[i + 2] ^ K[i + 3] ^ CK[i];
-        K[i + 4] = K[i] ^ sm4_t_table(tmp);
-        rk[i] = K[i + 4];
-    }
+static inline __m128i sm4_post_hi() {
+    return _mm_setr_epi8(0x00, (char)0xe0, 0x50, (char)0xb0, (char)0x9d, 0x7d, (char)0xcd, 0x2d,
+        (char)0xc0, 0x20, (char)0x90, 0x70, 0x5d, (char)0xbd, 0x0d, (char)0xed);
+}
+// λaesenclastеShiftRows
+static inline __m128i sm4_inv_shift_rows() {
+    return _mm_setr_epi8(0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3);
 }
 
-// ܣT-table汾
-void sm4_encrypt_block(const uint8_t in[16], uint8_t out[16], const uint32_t rk[32]) {
-    uint32_t X[36];
-    for (int i = 0; i < 4; i++) {
-        X[i] = ((uint32_t)in[4 * i] << 24) | ((uint32_t)in[4 * i + 1] << 16) |
-            ((uint32_t)in[4 * i + 2] << 8) | in[4 * i + 3];
-    }
-    for (int i = 0; i < 32; i++) {
-        uint32_t tmp = X[i + 1] ^ X[i + 2] ^ X[i + 3] ^ rk[i];
-        X[i + 4] = X[i] ^ sm4_t_table(tmp);
-    }
-    // 
-    for (int i = 0; i < 4; i++) {
-        out[4 * i] = (X[35 - i] >> 24) & 0xFF;
-        out[4 * i + 1] = (X[35 - i] >> 16) & 0xFF;
-        out[4 * i + 2] = (X[35 - i] >> 8) & 0xFF;
-        out[4 * i + 3] = X[35 - i] & 0xFF;
-    }
+// ֽ任4bit͸4bit
+SM4_TARGET("ssse3")
+static inline __m128i sm4_affine(__m128i x, __m128i lo_tab, __m128i hi_tab) {
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    __m128i lo = _mm_and_si128(x, mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi32(x, 4), mask);
+    return _mm_xor_si128(_mm_shuffle_epi8(lo_tab, lo), _mm_shuffle_epi8(hi_tab, hi));
 }
 
-// ====== AES-NI ٵ Sб任 =====
-// AES-NI _mm_aesenclast_si128 ָģSвҪ4ֽڵ128bit
+// 16ֽͬʱSM4 S
+SM4_TARGET("ssse3,aes")
 static inline __m128i aesni_sbox(__m128i x) {
-    // ʹÿԿȫ
-    __m128i zero = _mm_setzero_si128();
-    return _mm_aesenclast_si128(x, zero);
+    x = sm4_affine(x, sm4_pre_lo(), sm4_pre_hi());
+    x = _mm_shuffle_epi8(x, sm4_inv_shift_rows());
+    x = _mm_aesenclast_si128(x, _mm_setzero_si128());
+    return sm4_affine(x, sm4_post_lo(), sm4_post_hi());
 }
 
 // AES-NI汾ĵܣʾֻTSв
+SM4_TARGET("ssse3,aes")
 void sm4_encrypt_block_aesni(const uint8_t in[16], uint8_t out[16], const uint32_t rk[32]) {
     uint32_t X[36];
     for (int i = 0; i < 4; i++) {
@@ -156,89 +96,389 @@ void sm4_encrypt_block_aesni(const uint8_t in[16], uint8_t out[16], const uint32
     }
 }
 
-// ====== AVX2 м4 (ʾʵ) =====
-void sm4_encrypt_4blocks_avx2(const uint8_t in[4][16], uint8_t out[4][16], const uint32_t rk[32]) {
-    // ֻʾһֺĲУʵѭ32
-    // ʾX[0],X[1],X[2],X[3]ĿͬʱغͲ
+// ====== AES-NI 4·м =====
+// 汾ÿֻõSе4ֽڣ/ĿԶSбʵT-table
+// 4תõ4__m128iУһaesenclast4SУṹAVX2汾ͬ
+
+// T任Lֽλpshufb
+SM4_TARGET("ssse3,aes")
+static inline __m128i sm4_t_sse(__m128i x) {
+    const __m128i r8 = _mm_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    const __m128i r16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m128i r24 = _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    __m128i b = aesni_sbox(x);
+    __m128i t = _mm_xor_si128(b, _mm_xor_si128(_mm_shuffle_epi8(b, r8), _mm_shuffle_epi8(b, r16)));
+    t = _mm_or_si128(_mm_slli_epi32(t, 2), _mm_srli_epi32(t, 30));
+    return _mm_xor_si128(_mm_xor_si128(b, _mm_shuffle_epi8(b, r24)), t);
+}
+
+#define SM4_TRANSPOSE_4x4_SSE(x0, x1, x2, x3) do {      \
+        __m128i t0 = _mm_unpacklo_epi32(x0, x1);        \
+        __m128i t1 = _mm_unpackhi_epi32(x0, x1);        \
+        __m128i t2 = _mm_unpacklo_epi32(x2, x3);        \
+        __m128i t3 = _mm_unpackhi_epi32(x2, x3);        \
+        x0 = _mm_unpacklo_epi64(t0, t2);                \
+        x1 = _mm_unpackhi_epi64(t0, t2);                \
+        x2 = _mm_unpacklo_epi64(t1, t3);                \
+        x3 = _mm_unpackhi_epi64(t1, t3);                \
+    } while (0)
+
+// һμ4
+SM4_TARGET("ssse3,aes")
+static void sm4_encrypt_4blocks_aesni(const uint32_t rk[32], const uint8_t* in, uint8_t* out) {
+    const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m128i X0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 0)), bswap);
+    __m128i X1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 16)), bswap);
+    __m128i X2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 32)), bswap);
+    __m128i X3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 48)), bswap);
+    SM4_TRANSPOSE_4x4_SSE(X0, X1, X2, X3);
+
+    for (int i = 0; i < 32; i += 4) {
+        X0 = _mm_xor_si128(X0, sm4_t_sse(_mm_xor_si128(_mm_xor_si128(X1, X2),
+            _mm_xor_si128(X3, _mm_set1_epi32((int)rk[i])))));
+        X1 = _mm_xor_si128(X1, sm4_t_sse(_mm_xor_si128(_mm_xor_si128(X2, X3),
+            _mm_xor_si128(X0, _mm_set1_epi32((int)rk[i + 1])))));
+        X2 = _mm_xor_si128(X2, sm4_t_sse(_mm_xor_si128(_mm_xor_si128(X3, X0),
+            _mm_xor_si128(X1, _mm_set1_epi32((int)rk[i + 2])))));
+        X3 = _mm_xor_si128(X3, sm4_t_sse(_mm_xor_si128(_mm_xor_si128(X0, X1),
+            _mm_xor_si128(X2, _mm_set1_epi32((int)rk[i + 3])))));
+    }
 
-    __m256i X0, X1, X2, X3; // 4״̬Ĵ
+    SM4_TRANSPOSE_4x4_SSE(X3, X2, X1, X0);
+    _mm_storeu_si128((__m128i*)(out + 0), _mm_shuffle_epi8(X3, bswap));
+    _mm_storeu_si128((__m128i*)(out + 16), _mm_shuffle_epi8(X2, bswap));
+    _mm_storeu_si128((__m128i*)(out + 32), _mm_shuffle_epi8(X1, bswap));
+    _mm_storeu_si128((__m128i*)(out + 48), _mm_shuffle_epi8(X0, bswap));
+}
 
-    // 4blockĳʼ4֣16ֽ*4
-    // мطʽ򻯣ʵֽת
+// ܣAES-NI汾4һ鲢СAES-NI汾ÿֶҪ/
+// T-tableܶࡣβ1~2T-table3鲹һ4飨ʵ2ʱT-tableԸ죩
+SM4_TARGET("ssse3,aes")
+void sm4_encrypt_blocks_aesni(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    while (nblocks >= 4) {
+        sm4_encrypt_4blocks_aesni(rk, in, out);
+        in += 4 * 16;
+        out += 4 * 16;
+        nblocks -= 4;
+    }
+    if (nblocks == 3) {
+        uint8_t buf[4 * 16] = { 0 };
+        memcpy(buf, in, 16 * nblocks);
+        sm4_encrypt_4blocks_aesni(rk, buf, buf);
+        memcpy(out, buf, 16 * nblocks);
+        return;
+    }
+    for (size_t i = 0; i < nblocks; i++) {
+        sm4_encrypt_block(in + 16 * i, out + 16 * i, rk);
+    }
+}
 
-    uint32_t X[4][36];
+// ====== AVX2 鲢м =====
+// 8תú4__m256iУXiĵj32λlaneǵjĵi֣
+// 32ȫڼĴɣSAES-NIͬLλʵ֡
 
-    // ʼX
-    for (int blk = 0; blk < 4; blk++) {
-        for (int i = 0; i < 4; i++) {
-            X[blk][i] = ((uint32_t)in[blk][4 * i] << 24) |
-                ((uint32_t)in[blk][4 * i + 1] << 16) |
-                ((uint32_t)in[blk][4 * i + 2] << 8) |
-                in[blk][4 * i + 3];
-        }
+SM4_TARGET("avx2,aes")
+static inline __m256i mm256_rotl_epi32(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+// 256λ汾ķ任128λlaneʹͬı
+SM4_TARGET("avx2,aes")
+static inline __m256i sm4_affine_avx2(__m256i x, __m128i lo_tab, __m128i hi_tab) {
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(x, mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi32(x, 4), mask);
+    return _mm256_xor_si256(_mm256_shuffle_epi8(_mm256_broadcastsi128_si256(lo_tab), lo),
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(hi_tab), hi));
+}
+
+// 32ֽSУaesenclastֻ128λ汾ֱִ
+SM4_TARGET("avx2,aes")
+static inline __m256i sm4_sbox_avx2(__m256i x) {
+    x = sm4_affine_avx2(x, sm4_pre_lo(), sm4_pre_hi());
+    x = _mm256_shuffle_epi8(x, _mm256_broadcastsi128_si256(sm4_inv_shift_rows()));
+    __m128i lo = _mm_aesenclast_si128(_mm256_castsi256_si128(x), _mm_setzero_si128());
+    __m128i hi = _mm_aesenclast_si128(_mm256_extracti128_si256(x, 1), _mm_setzero_si128());
+    x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    return sm4_affine_avx2(x, sm4_post_lo(), sm4_post_hi());
+}
+
+// T任L(B) = B ^ (B<<<2) ^ (B<<<10) ^ (B<<<18) ^ (B<<<24)
+//            = B ^ (B<<<24) ^ ((B ^ (B<<<8) ^ (B<<<16)) <<< 2)ֽȵλpshufb
+SM4_TARGET("avx2,aes")
+static inline __m256i sm4_t_avx2(__m256i x) {
+    const __m256i r8 = _mm256_setr_epi8(
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    const __m256i r16 = _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i r24 = _mm256_setr_epi8(
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    __m256i b = sm4_sbox_avx2(x);
+    __m256i t = _mm256_xor_si256(b, _mm256_xor_si256(_mm256_shuffle_epi8(b, r8), _mm256_shuffle_epi8(b, r16)));
+    return _mm256_xor_si256(_mm256_xor_si256(b, _mm256_shuffle_epi8(b, r24)), mm256_rotl_epi32(t, 2));
+}
+
+// ÿ128λlane4x432λת
+#define SM4_TRANSPOSE_4x4(x0, x1, x2, x3) do {          \
+        __m256i t0 = _mm256_unpacklo_epi32(x0, x1);     \
+        __m256i t1 = _mm256_unpackhi_epi32(x0, x1);     \
+        __m256i t2 = _mm256_unpacklo_epi32(x2, x3);     \
+        __m256i t3 = _mm256_unpackhi_epi32(x2, x3);     \
+        x0 = _mm256_unpacklo_epi64(t0, t2);             \
+        x1 = _mm256_unpackhi_epi64(t0, t2);             \
+        x2 = _mm256_unpacklo_epi64(t1, t3);             \
+        x3 = _mm256_unpackhi_epi64(t1, t3);             \
+    } while (0)
+
+// һμ8
+SM4_TARGET("avx2,aes")
+static void sm4_encrypt_8blocks_avx2(const uint32_t rk[32], const uint8_t* in, uint8_t* out) {
+    // 鰴˶룬Ȱÿ32λֽת
+    const __m256i bswap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    // ÿĴװ2(laneΪż飬laneΪ)תúXiΪĵi
+    __m256i X0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + 0)), bswap);
+    __m256i X1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + 32)), bswap);
+    __m256i X2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + 64)), bswap);
+    __m256i X3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + 96)), bswap);
+    SM4_TRANSPOSE_4x4(X0, X1, X2, X3);
+
+    // ֱ任ÿ4ּĴɫֻһ
+    for (int i = 0; i < 32; i += 4) {
+        X0 = _mm256_xor_si256(X0, sm4_t_avx2(_mm256_xor_si256(_mm256_xor_si256(X1, X2),
+            _mm256_xor_si256(X3, _mm256_set1_epi32((int)rk[i])))));
+        X1 = _mm256_xor_si256(X1, sm4_t_avx2(_mm256_xor_si256(_mm256_xor_si256(X2, X3),
+            _mm256_xor_si256(X0, _mm256_set1_epi32((int)rk[i + 1])))));
+        X2 = _mm256_xor_si256(X2, sm4_t_avx2(_mm256_xor_si256(_mm256_xor_si256(X3, X0),
+            _mm256_xor_si256(X1, _mm256_set1_epi32((int)rk[i + 2])))));
+        X3 = _mm256_xor_si256(X3, sm4_t_avx2(_mm256_xor_si256(_mm256_xor_si256(X0, X1),
+            _mm256_xor_si256(X2, _mm256_set1_epi32((int)rk[i + 3])))));
     }
 
-    // ֻʾ1ּܼ
-    for (int blk = 0; blk < 4; blk++) {
-        uint32_t tmp = X[blk][1] ^ X[blk][2] ^ X[blk][3] ^ rk[0];
-        X[blk][4] = X[blk][0] ^ sm4_t_table(tmp);
+    // (X35,X34,X33,X32)תûذ
+    SM4_TRANSPOSE_4x4(X3, X2, X1, X0);
+    _mm256_storeu_si256((__m256i*)(out + 0), _mm256_shuffle_epi8(X3, bswap));
+    _mm256_storeu_si256((__m256i*)(out + 32), _mm256_shuffle_epi8(X2, bswap));
+    _mm256_storeu_si256((__m256i*)(out + 64), _mm256_shuffle_epi8(X1, bswap));
+    _mm256_storeu_si256((__m256i*)(out + 96), _mm256_shuffle_epi8(X0, bswap));
+}
+
+// ܣ8һAVX28βT-table
+SM4_TARGET("avx2,aes")
+void sm4_encrypt_blocks_avx2(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    while (nblocks >= 8) {
+        sm4_encrypt_8blocks_avx2(rk, in, out);
+        in += 8 * 16;
+        out += 8 * 16;
+        nblocks -= 8;
+    }
+    for (size_t i = 0; i < nblocks; i++) {
+        sm4_encrypt_block(in + 16 * i, out + 16 * i, rk);
     }
+}
 
-    // ת
-    for (int blk = 0; blk < 4; blk++) {
-        for (int i = 0; i < 4; i++) {
-            uint32_t val = X[blk][35 - i];
-            out[blk][4 * i] = (val >> 24) & 0xFF;
-            out[blk][4 * i + 1] = (val >> 16) & 0xFF;
-            out[blk][4 * i + 2] = (val >> 8) & 0xFF;
-            out[blk][4 * i + 3] = val & 0xFF;
-        }
+// ====== ԿչAVX2=====
+// 8ԿͬķʽתãKiÿ32λlaneһԿĵi֡
+// ԿչT'ֻǰL L'(B) = B ^ (B<<<13) ^ (B<<<23)Sܹá
+
+SM4_TARGET("avx2,aes")
+static inline __m256i sm4_key_t_avx2(__m256i x) {
+    __m256i b = sm4_sbox_avx2(x);
+    return _mm256_xor_si256(b, _mm256_xor_si256(mm256_rotl_epi32(b, 13), mm256_rotl_epi32(b, 23)));
+}
+
+// һչ8ԿkeysΪŵ816ֽԿ
+SM4_TARGET("avx2,aes")
+void sm4_key_schedule_x8_avx2(const uint8_t* keys, uint32_t rk[][SM4_NUM_ROUNDS]) {
+    const __m256i bswap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i K0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(keys + 0)), bswap);
+    __m256i K1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(keys + 32)), bswap);
+    __m256i K2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(keys + 64)), bswap);
+    __m256i K3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(keys + 96)), bswap);
+    SM4_TRANSPOSE_4x4(K0, K1, K2, K3);
+    K0 = _mm256_xor_si256(K0, _mm256_set1_epi32((int)sm4_FK[0]));
+    K1 = _mm256_xor_si256(K1, _mm256_set1_epi32((int)sm4_FK[1]));
+    K2 = _mm256_xor_si256(K2, _mm256_set1_epi32((int)sm4_FK[2]));
+    K3 = _mm256_xor_si256(K3, _mm256_set1_epi32((int)sm4_FK[3]));
+
+    for (int i = 0; i < 32; i += 4) {
+        K0 = _mm256_xor_si256(K0, sm4_key_t_avx2(_mm256_xor_si256(_mm256_xor_si256(K1, K2),
+            _mm256_xor_si256(K3, _mm256_set1_epi32((int)sm4_CK[i])))));
+        K1 = _mm256_xor_si256(K1, sm4_key_t_avx2(_mm256_xor_si256(_mm256_xor_si256(K2, K3),
+            _mm256_xor_si256(K0, _mm256_set1_epi32((int)sm4_CK[i + 1])))));
+        K2 = _mm256_xor_si256(K2, sm4_key_t_avx2(_mm256_xor_si256(_mm256_xor_si256(K3, K0),
+            _mm256_xor_si256(K1, _mm256_set1_epi32((int)sm4_CK[i + 2])))));
+        K3 = _mm256_xor_si256(K3, sm4_key_t_avx2(_mm256_xor_si256(_mm256_xor_si256(K0, K1),
+            _mm256_xor_si256(K2, _mm256_set1_epi32((int)sm4_CK[i + 3])))));
+
+        // K0..K3 Ϊi..i+3ֵԿתûȥÿ128λlaneһԿ4Կ
+        __m256i r0 = K0, r1 = K1, r2 = K2, r3 = K3;
+        SM4_TRANSPOSE_4x4(r0, r1, r2, r3);
+        _mm_storeu_si128((__m128i*)(rk[0] + i), _mm256_castsi256_si128(r0));
+        _mm_storeu_si128((__m128i*)(rk[1] + i), _mm256_extracti128_si256(r0, 1));
+        _mm_storeu_si128((__m128i*)(rk[2] + i), _mm256_castsi256_si128(r1));
+        _mm_storeu_si128((__m128i*)(rk[3] + i), _mm256_extracti128_si256(r1, 1));
+        _mm_storeu_si128((__m128i*)(rk[4] + i), _mm256_castsi256_si128(r2));
+        _mm_storeu_si128((__m128i*)(rk[5] + i), _mm256_extracti128_si256(r2, 1));
+        _mm_storeu_si128((__m128i*)(rk[6] + i), _mm256_castsi256_si128(r3));
+        _mm_storeu_si128((__m128i*)(rk[7] + i), _mm256_extracti128_si256(r3, 1));
     }
 }
 
-int main() {
-    // ʼT-table
-    init_t_tables();
+// ====== GFNI + AVX-512 16·м =====
+// 16תú4__m512iСSֱGFNI
+//   vgf2p8affineqb    : Pre䣬SM4ӳ䵽AES
+//   vgf2p8affineinvqb : AESPost䣬ӳSM4
+// L任4vproldvpternlogd(0x96Ϊ)ϲ
+
+// GF2P8AFFINE8x8ؾ󣬵iضӦĵ(7-i)ֽ
+#define SM4_GFNI_PRE_MATRIX  0x4c287db91a22505dULL
+#define SM4_GFNI_PRE_CONST   0x3e
+#define SM4_GFNI_POST_MATRIX 0xf3ab34a974a6b589ULL
+#define SM4_GFNI_POST_CONST  0xd3
+
+SM4_TARGET("avx512f,avx512bw,gfni")
+static inline __m512i sm4_sbox_gfni(__m512i x) {
+    const __m512i pre = _mm512_set1_epi64((long long)SM4_GFNI_PRE_MATRIX);
+    const __m512i post = _mm512_set1_epi64((long long)SM4_GFNI_POST_MATRIX);
+    __m512i b = _mm512_gf2p8affine_epi64_epi8(x, pre, SM4_GFNI_PRE_CONST);
+    return _mm512_gf2p8affineinv_epi64_epi8(b, post, SM4_GFNI_POST_CONST);
+}
 
-    uint8_t key[16] = {
-        0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
-        0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10
-    };
-    uint32_t rk[32];
-    sm4_key_schedule(key, rk);
+SM4_TARGET("avx512f,avx512bw,gfni")
+static inline __m512i sm4_t_gfni(__m512i x) {
+    __m512i b = sm4_sbox_gfni(x);
+    __m512i t = _mm512_ternarylogic_epi32(b, _mm512_rol_epi32(b, 2), _mm512_rol_epi32(b, 10), 0x96);
+    return _mm512_ternarylogic_epi32(t, _mm512_rol_epi32(b, 18), _mm512_rol_epi32(b, 24), 0x96);
+}
 
-    uint8_t plaintext[16] = {
-        0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
-        0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10
-    };
+// ֺ X1 ^ X2 ^ X3 ^ rk
+SM4_TARGET("avx512f,avx512bw,gfni")
+static inline __m512i sm4_round_in_gfni(__m512i x1, __m512i x2, __m512i x3, uint32_t rk) {
+    return _mm512_ternarylogic_epi32(x1, x2, _mm512_xor_si512(x3, _mm512_set1_epi32((int)rk)), 0x96);
+}
 
-    uint8_t ciphertext[16];
+// AVX2汾ͬlane4x4ת
+SM4_TARGET("avx512f,avx512bw,gfni")
+static inline void sm4_transpose_4x4_512(__m512i& x0, __m512i& x1, __m512i& x2, __m512i& x3) {
+    __m512i t0 = _mm512_unpacklo_epi32(x0, x1);
+    __m512i t1 = _mm512_unpackhi_epi32(x0, x1);
+    __m512i t2 = _mm512_unpacklo_epi32(x2, x3);
+    __m512i t3 = _mm512_unpackhi_epi32(x2, x3);
+    x0 = _mm512_unpacklo_epi64(t0, t2);
+    x1 = _mm512_unpackhi_epi64(t0, t2);
+    x2 = _mm512_unpacklo_epi64(t1, t3);
+    x3 = _mm512_unpackhi_epi64(t1, t3);
+}
 
-    printf("=== T-table 汾ܽ ===\n");
-    sm4_encrypt_block(plaintext, ciphertext, rk);
-    for (int i = 0; i < 16; i++) printf("%02x ", ciphertext[i]);
-    printf("\n");
+// һμ16飬nblocks < 16 ʱдlane
+SM4_TARGET("avx512f,avx512bw,gfni")
+static void sm4_encrypt_16blocks_gfni(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    const __m512i bswap = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+
+    // ÿĴװ416֣mask[k]ƵkĴЧ
+    __mmask16 mask[4];
+    for (int k = 0; k < 4; k++) {
+        size_t n = nblocks > 4u * k ? nblocks - 4u * k : 0;
+        mask[k] = n >= 4 ? (__mmask16)0xFFFF : (__mmask16)((1u << (4 * n)) - 1);
+    }
 
-    printf("=== AES-NI ٰ汾ܽ ===\n");
-    sm4_encrypt_block_aesni(plaintext, ciphertext, rk);
-    for (int i = 0; i < 16; i++) printf("%02x ", ciphertext[i]);
-    printf("\n");
+    __m512i X0 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[0], in + 0), bswap);
+    __m512i X1 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[1], in + 64), bswap);
+    __m512i X2 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[2], in + 128), bswap);
+    __m512i X3 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[3], in + 192), bswap);
 
-    // ׼4Ŀ
-    uint8_t in4[4][16];
-    uint8_t out4[4][16];
-    for (int i = 0; i < 4; i++) {
-        for (int j = 0; j < 16; j++) {
-            in4[i][j] = plaintext[j];
-        }
+    sm4_transpose_4x4_512(X0, X1, X2, X3);
+
+    for (int i = 0; i < 32; i += 4) {
+        X0 = _mm512_xor_si512(X0, sm4_t_gfni(sm4_round_in_gfni(X1, X2, X3, rk[i])));
+        X1 = _mm512_xor_si512(X1, sm4_t_gfni(sm4_round_in_gfni(X2, X3, X0, rk[i + 1])));
+        X2 = _mm512_xor_si512(X2, sm4_t_gfni(sm4_round_in_gfni(X3, X0, X1, rk[i + 2])));
+        X3 = _mm512_xor_si512(X3, sm4_t_gfni(sm4_round_in_gfni(X0, X1, X2, rk[i + 3])));
     }
-    printf("=== AVX2 4(1ʾ) ===\n");
-    sm4_encrypt_4blocks_avx2(in4, out4, rk);
-    for (int blk = 0; blk < 4; blk++) {
-        printf("Block %d: ", blk);
-        for (int i = 0; i < 16; i++) printf("%02x ", out4[blk][i]);
-        printf("\n");
+
+    // תûذ
+    sm4_transpose_4x4_512(X3, X2, X1, X0);
+
+    _mm512_mask_storeu_epi32(out + 0, mask[0], _mm512_shuffle_epi8(X3, bswap));
+    _mm512_mask_storeu_epi32(out + 64, mask[1], _mm512_shuffle_epi8(X2, bswap));
+    _mm512_mask_storeu_epi32(out + 128, mask[2], _mm512_shuffle_epi8(X1, bswap));
+    _mm512_mask_storeu_epi32(out + 192, mask[3], _mm512_shuffle_epi8(X0, bswap));
+}
+
+// ܣ16һ飬β汾ں˵ӳ޹أԼ410ڣ
+// ֻʣ1ʱT-table죨Լ330ڣ2GFNIռ
+SM4_TARGET("avx512f,avx512bw,gfni")
+void sm4_encrypt_blocks_gfni(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    while (nblocks > 0) {
+        if (nblocks == 1) {
+            sm4_encrypt_block(in, out, rk);
+            return;
+        }
+        size_t n = nblocks < 16 ? nblocks : 16;
+        sm4_encrypt_16blocks_gfni(rk, in, out, n);
+        in += n * 16;
+        out += n * 16;
+        nblocks -= n;
     }
+}
+
+// ====== ԿչGFNI + AVX-512=====
+// 16Կ sm4_encrypt_16blocks_gfni ͬ16ʱȡ
+
+SM4_TARGET("avx512f,avx512bw,gfni")
+static inline __m512i sm4_key_t_gfni(__m512i x) {
+    __m512i b = sm4_sbox_gfni(x);
+    return _mm512_ternarylogic_epi32(b, _mm512_rol_epi32(b, 13), _mm512_rol_epi32(b, 23), 0x96);
+}
 
-    return 0;
+SM4_TARGET("avx512f,avx512bw,gfni")
+void sm4_key_schedule_x16_gfni(const uint8_t* keys, size_t nkeys, uint32_t rk[][SM4_NUM_ROUNDS]) {
+    const __m512i bswap = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    if (nkeys > 16) nkeys = 16;
+
+    __mmask16 mask[4];
+    for (int k = 0; k < 4; k++) {
+        size_t n = nkeys > 4u * k ? nkeys - 4u * k : 0;
+        mask[k] = n >= 4 ? (__mmask16)0xFFFF : (__mmask16)((1u << (4 * n)) - 1);
+    }
+    __m512i K0 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[0], keys + 0), bswap);
+    __m512i K1 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[1], keys + 64), bswap);
+    __m512i K2 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[2], keys + 128), bswap);
+    __m512i K3 = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(mask[3], keys + 192), bswap);
+    sm4_transpose_4x4_512(K0, K1, K2, K3);
+    K0 = _mm512_xor_si512(K0, _mm512_set1_epi32((int)sm4_FK[0]));
+    K1 = _mm512_xor_si512(K1, _mm512_set1_epi32((int)sm4_FK[1]));
+    K2 = _mm512_xor_si512(K2, _mm512_set1_epi32((int)sm4_FK[2]));
+    K3 = _mm512_xor_si512(K3, _mm512_set1_epi32((int)sm4_FK[3]));
+
+    for (int i = 0; i < 32; i += 4) {
+        K0 = _mm512_xor_si512(K0, sm4_key_t_gfni(sm4_round_in_gfni(K1, K2, K3, sm4_CK[i])));
+        K1 = _mm512_xor_si512(K1, sm4_key_t_gfni(sm4_round_in_gfni(K2, K3, K0, sm4_CK[i + 1])));
+        K2 = _mm512_xor_si512(K2, sm4_key_t_gfni(sm4_round_in_gfni(K3, K0, K1, sm4_CK[i + 2])));
+        K3 = _mm512_xor_si512(K3, sm4_key_t_gfni(sm4_round_in_gfni(K0, K1, K2, sm4_CK[i + 3])));
+
+        // תûȥjĴĵk128λlaneǵ4j+kԿĵi..i+3Կ
+        __m512i r[4] = { K0, K1, K2, K3 };
+        sm4_transpose_4x4_512(r[0], r[1], r[2], r[3]);
+        for (size_t key = 0; key < nkeys; key++) {
+            __m128i v;
+            switch (key & 3) {
+            case 0: v = _mm512_extracti32x4_epi32(r[key >> 2], 0); break;
+            case 1: v = _mm512_extracti32x4_epi32(r[key >> 2], 1); break;
+            case 2: v = _mm512_extracti32x4_epi32(r[key >> 2], 2); break;
+            default: v = _mm512_extracti32x4_epi32(r[key >> 2], 3); break;
+            }
+            _mm_storeu_si128((__m128i*)(rk[key] + i), v);
+        }
+    }
 }
\ No newline at end of file
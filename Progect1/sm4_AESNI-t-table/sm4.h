@@ -0,0 +1,176 @@
+#ifndef SM4_H
+#define SM4_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SM4_BLOCK_SIZE 16
+#define SM4_KEY_SIZE 16
+#define SM4_NUM_ROUNDS 32
+
+// ָĿָʹͬһƿ԰ָںˣMSVCҪ
+#if defined(__GNUC__) || defined(__clang__)
+#define SM4_TARGET(x) __attribute__((target(x)))
+#else
+#define SM4_TARGET(x)
+#endif
+
+// ѡļں
+typedef enum {
+    SM4_KERNEL_TTABLE = 0,  // T-table
+    SM4_KERNEL_AESNI,       // AES-NI SУ
+    SM4_KERNEL_AVX2,        // AVX2 + AES-NI8鲢
+    SM4_KERNEL_GFNI,        // GFNI + AVX-51216鲢
+    SM4_KERNEL_BITSLICE,    // Ƭʱ䣬ᱻԶѡ
+    SM4_KERNEL_COUNT
+} sm4_kernel;
+
+// ԿչFKCKsm4-t-table.cpp
+extern const uint32_t sm4_FK[4];
+extern const uint32_t sm4_CK[32];
+
+// ܺ
+typedef void (*sm4_blocks_fn)(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+
+// Կչ
+void sm4_key_schedule(const uint8_t key[SM4_KEY_SIZE], uint32_t rk[SM4_NUM_ROUNDS]);
+
+// ԿSM4ܽṹֻͬԿʹá
+// rk_decκμں˼Ϊ
+void sm4_key_schedule_dec(const uint8_t key[SM4_KEY_SIZE], uint32_t rk_dec[SM4_NUM_ROUNDS]);
+
+// ܣT-table汾Ҳں˵Ĳοʵ֣
+void sm4_encrypt_block(const uint8_t in[SM4_BLOCK_SIZE], uint8_t out[SM4_BLOCK_SIZE], const uint32_t rk[SM4_NUM_ROUNDS]);
+
+// ܣT-table汾rk_decsm4_key_schedule_dec
+void sm4_decrypt_block(const uint8_t in[SM4_BLOCK_SIZE], uint8_t out[SM4_BLOCK_SIZE], const uint32_t rk_dec[SM4_NUM_ROUNDS]);
+
+// ܣAES-NI汾
+void sm4_encrypt_block_aesni(const uint8_t in[SM4_BLOCK_SIZE], uint8_t out[SM4_BLOCK_SIZE], const uint32_t rk[SM4_NUM_ROUNDS]);
+
+// ں˵Ķܣin/outΪnblocks
+void sm4_encrypt_blocks_ttable(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+void sm4_encrypt_blocks_aesni(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+void sm4_encrypt_blocks_avx2(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+void sm4_encrypt_blocks_gfni(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+
+// Ƭʱʵֱ֣64(uint64)/128(SSE2)/256(AVX2)Ϊһ
+// ûݵĲͷ֧sm4_encrypt_blockͬ
+void sm4_encrypt_blocks_bs64(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+void sm4_encrypt_blocks_bs128(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+void sm4_encrypt_blocks_bs256(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+
+// ԿչkeysΪŵ16ֽԿsm4_key_scheduleͬ
+// x8һչ8x1616nkeys < 16ʱֻдǰnkeys
+void sm4_key_schedule_x8_avx2(const uint8_t* keys, uint32_t rk[][SM4_NUM_ROUNDS]);
+void sm4_key_schedule_x16_gfni(const uint8_t* keys, size_t nkeys, uint32_t rk[][SM4_NUM_ROUNDS]);
+
+// ====== ʱ =====
+// ״ʹʱͨCPUID/XGETBVһCPUĿںˡ
+//  SM4_KERNEL=ttable|aesni|avx2|gfni|bitslice ǿָںˡ
+
+// CPUںˣظãֻеһЧ
+void sm4_init(void);
+
+// ܣʹõǰ󶨵ں
+void sm4_encrypt_blocks(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+
+// ǰCPUǷָ֧ں
+int sm4_kernel_supported(sm4_kernel k);
+
+// ǿлںˣ֧ʱ-1Ҳ޸
+int sm4_set_kernel(sm4_kernel k);
+
+// ǰ󶨵ں˼
+sm4_kernel sm4_get_kernel(void);
+const char* sm4_kernel_name(sm4_kernel k);
+
+// չnkeysԿǰںѡ16·(GFNI)/8·(AVX2)/
+void sm4_key_schedule_multi(const uint8_t* keys, size_t nkeys, uint32_t rk[][SM4_NUM_ROUNDS]);
+
+// ====== Կ =====
+// ͬһԿļܺͽԿչһκɷʹ
+
+typedef struct {
+    uint32_t rk[SM4_NUM_ROUNDS];      // Կ
+    uint32_t rk_dec[SM4_NUM_ROUNDS];  // Կ
+} sm4_key;
+
+void sm4_key_init(sm4_key* key, const uint8_t k[SM4_KEY_SIZE]);
+
+// һγʼnkeysԿkΪŵ16ֽԿ
+void sm4_key_init_multi(sm4_key* keys, const uint8_t* k, size_t nkeys);
+
+// ====== ģʽ =====
+// 鴦ģʽҪlenΪ16ı򷵻-1inoutͬԭز
+// iv/ctrڵúΪһεӦʹõֵһݿԷֶεã
+// CTR/OFB/CFBֶʱһⳤΪ16ı
+
+// ECBʹrk_dec
+int sm4_ecb_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t len);
+int sm4_ecb_decrypt(const uint32_t rk_dec[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t len);
+
+// CBC鴮УܰУʹrk_dec
+int sm4_cbc_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+int sm4_cbc_decrypt(const uint32_t rk_dec[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+
+// CTRctrΪ128λ˼ӽ֧ͬⳤ
+void sm4_ctr_crypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t ctr[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+
+// OFBӽ֧ͬⳤ
+void sm4_ofb_crypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+
+// CFB-128ʹüԿܿɲ
+void sm4_cfb_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+void sm4_cfb_decrypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+
+// ====== XTSģʽIEEE 1619=====
+// ڴ/ܣK1ݣK2tweakݵԪ16ֽڣ
+// ĩβһʱʹȡĵȳ
+
+typedef struct {
+    uint32_t rk1[SM4_NUM_ROUNDS];      // ԿK1ܣ
+    uint32_t rk1_dec[SM4_NUM_ROUNDS];  // ԿK1ܣ
+    uint32_t rk2[SM4_NUM_ROUNDS];      // tweakԿK2ֻ
+} sm4_xts_key;
+
+// kΪ32ֽ K1||K2K1K2ͬʱ-1
+int sm4_xts_set_key(sm4_xts_key* key, const uint8_t k[2 * SM4_KEY_SIZE]);
+
+// ӽһݵԪtweakΪ16ֽԭʼtweakδܣlen < 16ʱ-1
+int sm4_xts_encrypt(const sm4_xts_key* key, const uint8_t tweak[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+int sm4_xts_decrypt(const sm4_xts_key* key, const uint8_t tweak[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+
+// ӽnsectorsstweakΪ sector+s128λСˣ
+// in/outΪŵݣsector_size < 16ʱ-1
+int sm4_xts_encrypt_sectors(const sm4_xts_key* key, uint64_t sector, size_t sector_size,
+    const uint8_t* in, uint8_t* out, size_t nsectors);
+int sm4_xts_decrypt_sectors(const sm4_xts_key* key, uint64_t sector, size_t sector_size,
+    const uint8_t* in, uint8_t* out, size_t nsectors);
+
+// ====== ߳ =====
+// פ̳߳أ̰߳󶨵CPUˡĬ߳ΪCPU
+// û SM4_THREADS  sm4_set_num_threads() ޸ġ
+
+// /ȡ߳n <= 0 ʱָĬֵ
+void sm4_set_num_threads(int n);
+int sm4_get_num_threads(void);
+
+// [0, n)grainһηָ̳߳أε fn(arg, begin, end)ȫɺ󷵻ء
+// ͬһʱִֻһfnڲǶ׵ʱִУfnڲܵ sm4_set_num_threads
+typedef void (*sm4_range_fn)(void* arg, size_t begin, size_t end);
+void sm4_parallel_for(size_t n, size_t grain, sm4_range_fn fn, void* arg);
+
+// ߳CTR64 KiBжβУctrĸ sm4_ctr_crypt ȫͬ
+void sm4_ctr_crypt_mt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t ctr[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len);
+
+#endif // SM4_H
@@ -0,0 +1,269 @@
+#include "sm4.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#include <sched.h>
+#endif
+
+// ====== SM4 ܲ =====
+// ÿں˺ÿģʽ16 B ~ 64 MiBϢϲ
+// cycles/byterdtscGB/sεӳٵp50/p90/p99
+// ÷: sm4_bench [--max-size BYTES] [--time MS] [--json FILE]
+
+enum bench_mode {
+    MODE_ECB, MODE_CBC_ENC, MODE_CBC_DEC, MODE_CTR, MODE_XTS, MODE_CTR_MT, MODE_COUNT
+};
+static const char* const mode_names[MODE_COUNT] = { "ecb", "cbc-enc", "cbc-dec", "ctr", "xts", "ctr-mt" };
+
+struct bench_result {
+    const char* kernel;
+    const char* mode;
+    size_t size;
+    size_t calls;
+    double cpb;         // λ cycles/byte
+    double gbps;        // λ
+    double p50_ns, p90_ns, p99_ns;
+};
+
+// rdtscǰһlfenceõָԽʱȡǰƺִ
+static inline uint64_t rdtsc_fenced() {
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+
+static void pin_to_first_cpu() {
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), 1);
+#elif defined(__linux__)
+    cpu_set_t avail;
+    if (sched_getaffinity(0, sizeof(avail), &avail) != 0) return;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &avail)) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            sched_setaffinity(0, sizeof(one), &one);
+            return;
+        }
+    }
+#endif
+}
+
+// CPUID 0x80000002~4 Ĵ
+static void cpu_brand(char brand[49]) {
+    uint32_t r[12] = { 0 };
+    for (uint32_t i = 0; i < 3; i++) {
+#if defined(_MSC_VER)
+        __cpuid((int*)&r[4 * i], (int)(0x80000002 + i));
+#else
+        __get_cpuid(0x80000002 + i, &r[4 * i], &r[4 * i + 1], &r[4 * i + 2], &r[4 * i + 3]);
+#endif
+    }
+    memcpy(brand, r, 48);
+    brand[48] = 0;
+    // ȥǰո
+    char* p = brand;
+    while (*p == ' ') p++;
+    memmove(brand, p, strlen(p) + 1);
+}
+
+struct bench_ctx {
+    uint32_t rk[SM4_NUM_ROUNDS], rk_dec[SM4_NUM_ROUNDS];
+    sm4_xts_key xts;
+    uint8_t* in;
+    uint8_t* out;
+};
+
+static void run_once(bench_ctx& c, bench_mode mode, size_t size) {
+    uint8_t iv[16] = { 0 };
+    switch (mode) {
+    case MODE_ECB:
+        sm4_ecb_encrypt(c.rk, c.in, c.out, size);
+        break;
+    case MODE_CBC_ENC:
+        sm4_cbc_encrypt(c.rk, iv, c.in, c.out, size);
+        break;
+    case MODE_CBC_DEC:
+        sm4_cbc_decrypt(c.rk_dec, iv, c.in, c.out, size);
+        break;
+    case MODE_CTR:
+        sm4_ctr_crypt(c.rk, iv, c.in, c.out, size);
+        break;
+    case MODE_XTS:
+        // 4 KiBʱӿ
+        if (size % 4096 == 0) {
+            sm4_xts_encrypt_sectors(&c.xts, 0, 4096, c.in, c.out, size / 4096);
+        }
+        else {
+            sm4_xts_encrypt(&c.xts, iv, c.in, c.out, size);
+        }
+        break;
+    case MODE_CTR_MT:
+        sm4_ctr_crypt_mt(c.rk, iv, c.in, c.out, size);
+        break;
+    default:
+        break;
+    }
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t i = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+static bench_result measure(bench_ctx& c, bench_mode mode, size_t size, double budget_ms) {
+    using clock = std::chrono::steady_clock;
+
+    // Ԥȣ2ΣҲԤ1/10ƵʡTLBȶ״̬
+    auto t0 = clock::now();
+    for (int i = 0; i < 2 || std::chrono::duration<double, std::milli>(clock::now() - t0).count() < budget_ms / 10; i++) {
+        run_once(c, mode, size);
+    }
+
+    // ÿεõʱֱԤ㣻5ΣϢ3
+    std::vector<double> ns, cycles;
+    size_t min_calls = size >= (16u << 20) ? 3 : 5;
+    auto start = clock::now();
+    while (ns.size() < min_calls ||
+        (ns.size() < 100000 && std::chrono::duration<double, std::milli>(clock::now() - start).count() < budget_ms)) {
+        auto a = clock::now();
+        uint64_t ca = rdtsc_fenced();
+        run_once(c, mode, size);
+        uint64_t cb = rdtsc_fenced();
+        auto b = clock::now();
+        ns.push_back(std::chrono::duration<double, std::nano>(b - a).count());
+        cycles.push_back((double)(cb - ca));
+    }
+    std::sort(ns.begin(), ns.end());
+    std::sort(cycles.begin(), cycles.end());
+
+    bench_result r;
+    r.kernel = sm4_kernel_name(sm4_get_kernel());
+    r.mode = mode_names[mode];
+    r.size = size;
+    r.calls = ns.size();
+    r.cpb = percentile(cycles, 0.5) / (double)size;
+    r.p50_ns = percentile(ns, 0.5);
+    r.p90_ns = percentile(ns, 0.9);
+    r.p99_ns = percentile(ns, 0.99);
+    r.gbps = (double)size / r.p50_ns;
+    return r;
+}
+
+// JSONַţתšбܺͿַ
+static void json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') {
+            fprintf(f, "\\%c", ch);
+        }
+        else if (ch < 0x20) {
+            fprintf(f, "\\u%04x", ch);
+        }
+        else {
+            fputc(ch, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void write_json(FILE* f, const char* cpu, const std::vector<bench_result>& results) {
+    fprintf(f, "{\n  \"cpu\": ");
+    json_string(f, cpu);
+    fprintf(f, ",\n  \"threads\": %d,\n  \"results\": [\n", sm4_get_num_threads());
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result& r = results[i];
+        fprintf(f, "    {\"kernel\": \"%s\", \"mode\": \"%s\", \"size\": %zu, \"calls\": %zu, "
+            "\"cycles_per_byte\": %.3f, \"gb_per_s\": %.4f, "
+            "\"latency_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f}}%s\n",
+            r.kernel, r.mode, r.size, r.calls, r.cpb, r.gbps,
+            r.p50_ns, r.p90_ns, r.p99_ns, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static void noop_range(void*, size_t, size_t) {}
+
+int main(int argc, char** argv) {
+    size_t max_size = 64u << 20;
+    double budget_ms = 200;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            max_size = (size_t)strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            budget_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        }
+        else {
+            fprintf(stderr, "usage: %s [--max-size BYTES] [--time MS] [--json FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    sm4_init();
+    // Ƚٰ̳̰߳߳󶨵һCPUctr-mtĹ߳ԷֲڸCPU
+    sm4_parallel_for(sm4_get_num_threads(), 1, noop_range, NULL);
+    pin_to_first_cpu();
+
+    bench_ctx c;
+    uint8_t key[32];
+    for (int i = 0; i < 32; i++) key[i] = (uint8_t)(i * 37 + 1);
+    sm4_key_schedule(key, c.rk);
+    sm4_key_schedule_dec(key, c.rk_dec);
+    sm4_xts_set_key(&c.xts, key);
+
+    std::vector<uint8_t> in(max_size), out(max_size);
+    for (size_t i = 0; i < max_size; i++) in[i] = (uint8_t)(i * 31 + 7);
+    c.in = in.data();
+    c.out = out.data();
+
+    char cpu[49];
+    cpu_brand(cpu);
+    printf("CPU: %s, threads for ctr-mt: %d\n", cpu, sm4_get_num_threads());
+    printf("%-8s %-8s %10s %10s %9s %12s %12s %12s\n",
+        "kernel", "mode", "size", "cyc/byte", "GB/s", "p50 ns", "p90 ns", "p99 ns");
+
+    std::vector<bench_result> results;
+    sm4_kernel selected = sm4_get_kernel();
+    for (int k = 0; k < SM4_KERNEL_COUNT; k++) {
+        if (sm4_set_kernel((sm4_kernel)k) != 0) continue;
+        for (int m = 0; m < MODE_COUNT; m++) {
+            for (size_t size = 16; size <= max_size; size *= 4) {
+                bench_result r = measure(c, (bench_mode)m, size, budget_ms);
+                printf("%-8s %-8s %10zu %10.2f %9.3f %12.0f %12.0f %12.0f\n",
+                    r.kernel, r.mode, r.size, r.cpb, r.gbps, r.p50_ns, r.p90_ns, r.p99_ns);
+                fflush(stdout);
+                results.push_back(r);
+            }
+        }
+    }
+    sm4_set_kernel(selected);
+
+    if (json_path) {
+        FILE* f = fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot open %s\n", json_path);
+            return 1;
+        }
+        write_json(f, cpu, results);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include "sm4.h"
+#include <immintrin.h>
+
+// ====== Ƭ(bitslice)ʱʵ =====
+// Nתó128ƽ棺ƽ w*32+b ĵjλǵjwֵĵbλ
+// һеL任еѭλƽ֮/±ţ
+// Sò·㣬ûݵĲͷ֧
+// ƽͣuint64_t(64)SSE2 __m128i(128)AVX2 __m256i(256)
+
+#if defined(_MSC_VER)
+#define SM4_BS_INLINE __forceinline
+#else
+#define SM4_BS_INLINE inline __attribute__((always_inline))
+#endif
+
+// --- ƽ ---
+// ÿƽG64λɣgӦg64
+
+struct bs64 {
+    enum { G = 1 };
+    uint64_t v;
+    static SM4_BS_INLINE bs64 fill(uint64_t m) { bs64 r = { m }; return r; }
+    static SM4_BS_INLINE bs64 load(const uint64_t* p) { bs64 r = { p[0] }; return r; }
+    SM4_BS_INLINE void store(uint64_t* p) const { p[0] = v; }
+};
+static SM4_BS_INLINE bs64 operator^(bs64 a, bs64 b) { bs64 r = { a.v ^ b.v }; return r; }
+static SM4_BS_INLINE bs64 operator&(bs64 a, bs64 b) { bs64 r = { a.v & b.v }; return r; }
+static SM4_BS_INLINE bs64 operator~(bs64 a) { bs64 r = { ~a.v }; return r; }
+
+struct bs128 {
+    enum { G = 2 };
+    __m128i v;
+    static SM4_BS_INLINE bs128 fill(uint64_t m) { bs128 r = { _mm_set1_epi64x((long long)m) }; return r; }
+    static SM4_BS_INLINE bs128 load(const uint64_t* p) { bs128 r = { _mm_loadu_si128((const __m128i*)p) }; return r; }
+    SM4_BS_INLINE void store(uint64_t* p) const { _mm_storeu_si128((__m128i*)p, v); }
+};
+static SM4_BS_INLINE bs128 operator^(bs128 a, bs128 b) { bs128 r = { _mm_xor_si128(a.v, b.v) }; return r; }
+static SM4_BS_INLINE bs128 operator&(bs128 a, bs128 b) { bs128 r = { _mm_and_si128(a.v, b.v) }; return r; }
+static SM4_BS_INLINE bs128 operator~(bs128 a) { bs128 r = { _mm_xor_si128(a.v, _mm_set1_epi32(-1)) }; return r; }
+
+// AVX2汾ֻڴavx2Ŀĺչﲻalways_inline
+// ɱsm4_encrypt_blocks_bs256֮
+struct bs256 {
+    enum { G = 4 };
+    __m256i v;
+    SM4_TARGET("avx2") static inline bs256 fill(uint64_t m) { bs256 r = { _mm256_set1_epi64x((long long)m) }; return r; }
+    SM4_TARGET("avx2") static inline bs256 load(const uint64_t* p) { bs256 r = { _mm256_loadu_si256((const __m256i*)p) }; return r; }
+    SM4_TARGET("avx2") inline void store(uint64_t* p) const { _mm256_storeu_si256((__m256i*)p, v); }
+};
+SM4_TARGET("avx2") static inline bs256 operator^(bs256 a, bs256 b) { bs256 r = { _mm256_xor_si256(a.v, b.v) }; return r; }
+SM4_TARGET("avx2") static inline bs256 operator&(bs256 a, bs256 b) { bs256 r = { _mm256_and_si256(a.v, b.v) }; return r; }
+SM4_TARGET("avx2") static inline bs256 operator~(bs256 a) { bs256 r = { _mm256_xor_si256(a.v, _mm256_set1_epi32(-1)) }; return r; }
+
+// --- GF(2^4) 㣬ģ z^4 + z + 1a[0]Ϊ ---
+
+template <class W>
+static SM4_BS_INLINE void gf16_mul(const W a[4], const W b[4], W r[4]) {
+    W c0 = a[0] & b[0];
+    W c1 = (a[0] & b[1]) ^ (a[1] & b[0]);
+    W c2 = (a[0] & b[2]) ^ (a[1] & b[1]) ^ (a[2] & b[0]);
+    W c3 = (a[0] & b[3]) ^ (a[1] & b[2]) ^ (a[2] & b[1]) ^ (a[3] & b[0]);
+    W c4 = (a[1] & b[3]) ^ (a[2] & b[2]) ^ (a[3] & b[1]);
+    W c5 = (a[2] & b[3]) ^ (a[3] & b[2]);
+    W c6 = a[3] & b[3];
+    // z^4 = z + 1, z^5 = z^2 + z, z^6 = z^3 + z^2
+    r[0] = c0 ^ c4;
+    r[1] = c1 ^ c4 ^ c5;
+    r[2] = c2 ^ c5 ^ c6;
+    r[3] = c3 ^ c6;
+}
+
+// ƽԱ任
+template <class W>
+static SM4_BS_INLINE void gf16_sq(const W a[4], W r[4]) {
+    r[0] = a[0] ^ a[2];
+    r[1] = a[2];
+    r[2] = a[1] ^ a[3];
+    r[3] = a[3];
+}
+
+// 棺a^-1 = a^14 = a^2 * a^4 * a^80ӳ䵽0
+template <class W>
+static SM4_BS_INLINE void gf16_inv(const W a[4], W r[4]) {
+    W a2[4], a4[4], a8[4], t[4];
+    gf16_sq(a, a2);
+    gf16_sq(a2, a4);
+    gf16_sq(a4, a8);
+    gf16_mul(a2, a4, t);
+    gf16_mul(t, a8, r);
+}
+
+// --- Sе· ---
+// SM4 S S(x) = A*I(A*x + C) + CIΪģ0x1F5档GF(2^8)ͬ
+// GF(2^4)[y]/(y^2 + y + z^3)棬/Ļ任ACϲԲ㡣
+// Ԫ u = uh*y + ulu[0..3]Ϊulu[4..7]Ϊuh
+template <class W>
+static SM4_BS_INLINE void bs_sbox(const W x[8], W y[8]) {
+    W u[8], v[8];
+    u[0] = x[3] ^ x[4] ^ x[6] ^ x[7];
+    u[1] = x[0] ^ x[2] ^ x[5] ^ x[6];
+    u[2] = ~(x[1] ^ x[2] ^ x[3] ^ x[4] ^ x[5] ^ x[7]);
+    u[3] = ~(x[0] ^ x[1] ^ x[5] ^ x[6] ^ x[7]);
+    u[4] = x[0] ^ x[1] ^ x[4] ^ x[7];
+    u[5] = ~x[6];
+    u[6] = x[2] ^ x[6] ^ x[7];
+    u[7] = ~(x[0] ^ x[1] ^ x[2] ^ x[3] ^ x[4] ^ x[5] ^ x[6]);
+
+    // d = uh^2 * z^3 + uh * ul + ul^2
+    const W* uh = u + 4;
+    const W* ul = u;
+    W h2[4], l2[4], hl[4], d[4], di[4], s[4];
+    gf16_sq(uh, h2);
+    gf16_sq(ul, l2);
+    gf16_mul(uh, ul, hl);
+    // z^3ҲԱ任
+    d[0] = h2[1] ^ hl[0] ^ l2[0];
+    d[1] = h2[1] ^ h2[2] ^ hl[1] ^ l2[1];
+    d[2] = h2[2] ^ h2[3] ^ hl[2] ^ l2[2];
+    d[3] = h2[0] ^ h2[3] ^ hl[3] ^ l2[3];
+    gf16_inv(d, di);
+
+    // u^-1 = (uh * d^-1) * y + (uh + ul) * d^-1
+    s[0] = uh[0] ^ ul[0];
+    s[1] = uh[1] ^ ul[1];
+    s[2] = uh[2] ^ ul[2];
+    s[3] = uh[3] ^ ul[3];
+    gf16_mul(uh, di, v + 4);
+    gf16_mul(s, di, v);
+
+    y[0] = ~(v[0] ^ v[1] ^ v[4] ^ v[7]);
+    y[1] = ~(v[0] ^ v[2] ^ v[6]);
+    y[2] = v[2] ^ v[5] ^ v[6] ^ v[7];
+    y[3] = v[0] ^ v[2] ^ v[4] ^ v[7];
+    y[4] = ~(v[1] ^ v[3] ^ v[4]);
+    y[5] = v[1] ^ v[3] ^ v[4] ^ v[5] ^ v[7];
+    y[6] = ~(v[0] ^ v[1] ^ v[2] ^ v[4] ^ v[6]);
+    y[7] = ~(v[0] ^ v[3] ^ v[4]);
+}
+
+// --- 32 ---
+// X[w][b]Ϊwֵĵbλƽ棻Կÿһλչȫ0/ȫ1룬Կ֧
+template <class W>
+static SM4_BS_INLINE void bs_rounds(W X[4][32], const uint32_t rk[32]) {
+    for (int i = 0; i < 32; i++) {
+        W* x0 = X[i % 4];
+        const W* x1 = X[(i + 1) % 4];
+        const W* x2 = X[(i + 2) % 4];
+        const W* x3 = X[(i + 3) % 4];
+        W t[32], s[32];
+        for (int b = 0; b < 32; b++) {
+            t[b] = x1[b] ^ x2[b] ^ x3[b] ^ W::fill(0 - (uint64_t)((rk[i] >> b) & 1));
+        }
+        for (int k = 0; k < 4; k++) {
+            bs_sbox(t + 8 * k, s + 8 * k);
+        }
+        // LB<<<r ĵbλBĵ(b-r)λ
+        for (int b = 0; b < 32; b++) {
+            x0[b] = x0[b] ^ s[b] ^ s[(b + 30) & 31] ^ s[(b + 22) & 31] ^ s[(b + 14) & 31] ^ s[(b + 8) & 31];
+        }
+    }
+}
+
+// --- ת ---
+
+// 64x64ؾԭתãa[i]ĵjλa[j]ĵiλ
+static void transpose64(uint64_t a[64]) {
+    uint64_t m = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, m ^= (m << j)) {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+static inline uint32_t load_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// n(<=64)תplanes[ƽ][g]ƴһ64λУһתõõ64ƽ
+static void bs_pack(const uint8_t* in, size_t n, uint64_t (*planes)[4], int g) {
+    uint64_t m[64];
+    for (int p = 0; p < 2; p++) {
+        for (size_t j = 0; j < 64; j++) {
+            m[j] = j < n ? (uint64_t)load_be32(in + 16 * j + 8 * p) |
+                ((uint64_t)load_be32(in + 16 * j + 8 * p + 4) << 32) : 0;
+        }
+        transpose64(m);
+        for (int b = 0; b < 64; b++) {
+            planes[64 * p + b][g] = m[b];
+        }
+    }
+}
+
+// bs_pacḳ˳planesź
+static void bs_unpack(uint64_t (*planes)[4], int g, uint8_t* out, size_t n) {
+    uint64_t m[64];
+    for (int p = 0; p < 2; p++) {
+        for (int b = 0; b < 64; b++) {
+            m[b] = planes[64 * p + b][g];
+        }
+        transpose64(m);
+        for (size_t j = 0; j < n; j++) {
+            store_be32(out + 16 * j + 8 * p, (uint32_t)m[j]);
+            store_be32(out + 16 * j + 8 * p + 4, (uint32_t)(m[j] >> 32));
+        }
+    }
+}
+
+// һ 64*G 
+template <class W>
+static SM4_BS_INLINE void bs_encrypt_batch(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t n) {
+    uint64_t planes[128][4];
+    W X[4][32];
+
+    for (int g = 0; g < W::G; g++) {
+        size_t ng = n > 64u * g ? n - 64u * g : 0;
+        bs_pack(in + 64 * 16 * g, ng > 64 ? 64 : ng, planes, g);
+    }
+    for (int w = 0; w < 4; w++) {
+        for (int b = 0; b < 32; b++) {
+            X[w][b] = W::load(planes[32 * w + b]);
+        }
+    }
+
+    bs_rounds(X, rk);
+
+    // (X35,X34,X33,X32)
+    for (int w = 0; w < 4; w++) {
+        for (int b = 0; b < 32; b++) {
+            X[3 - w][b].store(planes[32 * w + b]);
+        }
+    }
+    for (int g = 0; g < W::G; g++) {
+        size_t ng = n > 64u * g ? n - 64u * g : 0;
+        bs_unpack(planes, g, out + 64 * 16 * g, ng > 64 ? 64 : ng);
+    }
+}
+
+// 64һ64һlane0
+void sm4_encrypt_blocks_bs64(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    while (nblocks > 0) {
+        size_t n = nblocks < 64 ? nblocks : 64;
+        bs_encrypt_batch<bs64>(rk, in, out, n);
+        in += 16 * n;
+        out += 16 * n;
+        nblocks -= n;
+    }
+}
+
+// 128һβ64汾Ϊ
+void sm4_encrypt_blocks_bs128(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    while (nblocks > 64) {
+        size_t n = nblocks < 128 ? nblocks : 128;
+        bs_encrypt_batch<bs128>(rk, in, out, n);
+        in += 16 * n;
+        out += 16 * n;
+        nblocks -= n;
+    }
+    sm4_encrypt_blocks_bs64(rk, in, out, nblocks);
+}
+
+SM4_TARGET("avx2")
+void sm4_encrypt_blocks_bs256(const uint32_t rk[32], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    while (nblocks > 128) {
+        size_t n = nblocks < 256 ? nblocks : 256;
+        bs_encrypt_batch<bs256>(rk, in, out, n);
+        in += 16 * n;
+        out += 16 * n;
+        nblocks -= n;
+    }
+    sm4_encrypt_blocks_bs128(rk, in, out, nblocks);
+}
@@ -0,0 +1,54 @@
+#include "sm4.h"
+#include <string.h>
+
+// ====== ߳CTR =====
+// гɶΣÿ飩cεʼΪ
+// ctr + c*ڿ128λӷλ̳߳ sm4_ctr_crypt 
+// 뵥߳ȫͬ
+
+#define SM4_CTR_MT_CHUNK (64 * 1024)   // ÿ64 KiB4096
+#define SM4_CTR_MT_MIN (256 * 1024)    // Сڸóʱֱӵ̴߳
+
+// 128λ˼n
+static void ctr128_add(uint8_t ctr[16], uint64_t n) {
+    for (int j = 15; j >= 0 && n != 0; j--) {
+        uint64_t s = (uint64_t)ctr[j] + (n & 0xFF);
+        ctr[j] = (uint8_t)s;
+        n = (n >> 8) + (s >> 8);
+    }
+}
+
+struct ctr_job {
+    const uint32_t* rk;
+    const uint8_t* ctr;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t len;
+};
+
+static void ctr_chunks(void* arg, size_t begin, size_t end) {
+    const ctr_job* job = (const ctr_job*)arg;
+    for (size_t c = begin; c < end; c++) {
+        size_t off = c * SM4_CTR_MT_CHUNK;
+        size_t len = job->len - off < SM4_CTR_MT_CHUNK ? job->len - off : SM4_CTR_MT_CHUNK;
+        uint8_t ctr[16];
+        memcpy(ctr, job->ctr, 16);
+        ctr128_add(ctr, off / 16);
+        sm4_ctr_crypt(job->rk, ctr, job->in + off, job->out + off, len);
+    }
+}
+
+void sm4_ctr_crypt_mt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t ctr[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    if (len < SM4_CTR_MT_MIN || sm4_get_num_threads() == 1) {
+        sm4_ctr_crypt(rk, ctr, in, out, len);
+        return;
+    }
+
+    ctr_job job = { rk, ctr, in, out, len };
+    size_t nchunks = (len + SM4_CTR_MT_CHUNK - 1) / SM4_CTR_MT_CHUNK;
+    sm4_parallel_for(nchunks, 1, ctr_chunks, &job);
+
+    // 뵥߳һ£ǰ ceil(len/16) 
+    ctr128_add(ctr, (len + 15) / 16);
+}
@@ -0,0 +1,179 @@
+#include "sm4.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// ====== CPUԼ =====
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t r[4]) {
+#if defined(_MSC_VER)
+    int t[4];
+    __cpuidex(t, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) r[i] = (uint32_t)t[i];
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &r[0], &r[1], &r[2], &r[3])) {
+        r[0] = r[1] = r[2] = r[3] = 0;
+    }
+#endif
+}
+
+// ȡXCR0ȷϲϵͳᱣYMM/ZMMĴ
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+// ںǷãsm4_initд
+static int kernel_ok[SM4_KERNEL_COUNT];
+static int has_avx2;
+
+static void detect_cpu() {
+    uint32_t r1[4], r7[4];
+    cpuid(0, 0, r1);
+    uint32_t max_leaf = r1[0];
+    cpuid(1, 0, r1);
+    if (max_leaf >= 7) {
+        cpuid(7, 0, r7);
+    }
+    else {
+        r7[0] = r7[1] = r7[2] = r7[3] = 0;
+    }
+
+    int ssse3 = (r1[2] >> 9) & 1;
+    int aes = (r1[2] >> 25) & 1;
+    int osxsave = (r1[2] >> 27) & 1;
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    int ymm_os = (xcr0 & 0x6) == 0x6;          // XMM + YMM
+    int zmm_os = (xcr0 & 0xE6) == 0xE6;        // XMM + YMM + opmask + ZMM
+    int avx2 = ymm_os && ((r1[2] >> 28) & 1) && ((r7[1] >> 5) & 1);
+    int avx512 = zmm_os && ((r7[1] >> 16) & 1) && ((r7[1] >> 30) & 1);  // AVX512F + AVX512BW
+    int gfni = (r7[2] >> 8) & 1;
+
+    kernel_ok[SM4_KERNEL_TTABLE] = 1;
+    kernel_ok[SM4_KERNEL_AESNI] = ssse3 && aes;
+    kernel_ok[SM4_KERNEL_AVX2] = avx2 && aes;
+    kernel_ok[SM4_KERNEL_GFNI] = avx512 && gfni;
+    kernel_ok[SM4_KERNEL_BITSLICE] = 1;
+    has_avx2 = avx2;
+}
+
+// ====== ں˰ =====
+
+static const char* const kernel_names[SM4_KERNEL_COUNT] = { "ttable", "aesni", "avx2", "gfni", "bitslice" };
+
+// Ƭں˰CPUѡƽȣdispatch_initȷ
+static sm4_blocks_fn kernel_fns[SM4_KERNEL_COUNT] = {
+    sm4_encrypt_blocks_ttable,
+    sm4_encrypt_blocks_aesni,
+    sm4_encrypt_blocks_avx2,
+    sm4_encrypt_blocks_gfni,
+    sm4_encrypt_blocks_bs128,
+};
+
+// Զѡʱ˳򣨴ӿ쵽Ƭֻʽָ
+static const sm4_kernel auto_order[] = {
+    SM4_KERNEL_GFNI, SM4_KERNEL_AVX2, SM4_KERNEL_AESNI, SM4_KERNEL_TTABLE
+};
+
+// ǰռλɼת֤̬ʼǰҲܵõȷ
+static void resolve_encrypt_blocks(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks);
+
+// ǰںֻ¼һԭӺָ룬sm4_get_kernel飬лѯ
+static std::atomic<sm4_blocks_fn> encrypt_blocks_fn(resolve_encrypt_blocks);
+
+static void dispatch_init() {
+    detect_cpu();
+    kernel_fns[SM4_KERNEL_BITSLICE] = has_avx2 ? sm4_encrypt_blocks_bs256 : sm4_encrypt_blocks_bs128;
+
+    // Ĭѡõں
+    sm4_kernel best = SM4_KERNEL_TTABLE;
+    for (size_t i = 0; i < sizeof(auto_order) / sizeof(auto_order[0]); i++) {
+        if (kernel_ok[auto_order[i]]) {
+            best = auto_order[i];
+            break;
+        }
+    }
+
+    // ǿָ
+    const char* env = getenv("SM4_KERNEL");
+    if (env && *env) {
+        int found = 0;
+        for (int k = 0; k < SM4_KERNEL_COUNT; k++) {
+            if (strcmp(env, kernel_names[k]) == 0) {
+                found = 1;
+                if (kernel_ok[k]) {
+                    best = (sm4_kernel)k;
+                }
+                else {
+                    fprintf(stderr, "SM4_KERNEL=%s is not supported on this CPU, using %s\n", env, kernel_names[best]);
+                }
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown SM4_KERNEL=%s, using %s\n", env, kernel_names[best]);
+        }
+    }
+
+    encrypt_blocks_fn.store(kernel_fns[best], std::memory_order_release);
+}
+
+void sm4_init(void) {
+    static std::once_flag once;
+    std::call_once(once, dispatch_init);
+}
+
+// ʱɼ⣬֮ĵòж⿪
+static struct sm4_startup {
+    sm4_startup() { sm4_init(); }
+} startup;
+
+static void resolve_encrypt_blocks(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    sm4_init();
+    encrypt_blocks_fn.load(std::memory_order_acquire)(rk, in, out, nblocks);
+}
+
+void sm4_encrypt_blocks(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    encrypt_blocks_fn.load(std::memory_order_acquire)(rk, in, out, nblocks);
+}
+
+int sm4_kernel_supported(sm4_kernel k) {
+    sm4_init();
+    return k >= 0 && k < SM4_KERNEL_COUNT && kernel_ok[k];
+}
+
+int sm4_set_kernel(sm4_kernel k) {
+    if (!sm4_kernel_supported(k)) {
+        return -1;
+    }
+    encrypt_blocks_fn.store(kernel_fns[k], std::memory_order_release);
+    return 0;
+}
+
+sm4_kernel sm4_get_kernel(void) {
+    sm4_init();
+    // kernel_fnsdispatch_init֮ٸı䣬ͬ
+    sm4_blocks_fn fn = encrypt_blocks_fn.load(std::memory_order_acquire);
+    for (int k = 0; k < SM4_KERNEL_COUNT; k++) {
+        if (kernel_fns[k] == fn) {
+            return (sm4_kernel)k;
+        }
+    }
+    return SM4_KERNEL_TTABLE;
+}
+
+const char* sm4_kernel_name(sm4_kernel k) {
+    return (k >= 0 && k < SM4_KERNEL_COUNT) ? kernel_names[k] : "unknown";
+}
@@ -0,0 +1,66 @@
+#include "sm4.h"
+#include <string.h>
+
+// ====== ԿչԿ =====
+// ǰ󶨵ںѡGFNIһ16AVX2һ8ںչ
+//  SM4_KERNEL=ttable ǿͬԿչ
+
+#define SM4_KEY_BATCH 16
+
+void sm4_key_schedule_multi(const uint8_t* keys, size_t nkeys, uint32_t rk[][SM4_NUM_ROUNDS]) {
+    sm4_kernel k = sm4_get_kernel();
+
+    if (k == SM4_KERNEL_GFNI) {
+        // ȡβ16ҲֱӴ
+        for (size_t i = 0; i < nkeys; i += 16) {
+            sm4_key_schedule_x16_gfni(keys + 16 * i, nkeys - i, rk + i);
+        }
+        return;
+    }
+
+    size_t i = 0;
+    if (k == SM4_KERNEL_AVX2) {
+        for (; i + 8 <= nkeys; i += 8) {
+            sm4_key_schedule_x8_avx2(keys + 16 * i, rk + i);
+        }
+        // ʣ2~7ʱ뵽8Աչ
+        if (nkeys - i >= 2) {
+            uint8_t pad_keys[8 * 16] = { 0 };
+            uint32_t pad_rk[8][SM4_NUM_ROUNDS];
+            memcpy(pad_keys, keys + 16 * i, 16 * (nkeys - i));
+            sm4_key_schedule_x8_avx2(pad_keys, pad_rk);
+            memcpy(rk + i, pad_rk, sizeof(pad_rk[0]) * (nkeys - i));
+            i = nkeys;
+        }
+    }
+    for (; i < nkeys; i++) {
+        sm4_key_schedule(keys + 16 * i, rk[i]);
+    }
+}
+
+// ɼԿõԿ
+static void reverse_rk(const uint32_t rk[SM4_NUM_ROUNDS], uint32_t rk_dec[SM4_NUM_ROUNDS]) {
+    for (int i = 0; i < SM4_NUM_ROUNDS; i++) {
+        rk_dec[i] = rk[SM4_NUM_ROUNDS - 1 - i];
+    }
+}
+
+void sm4_key_init(sm4_key* key, const uint8_t k[SM4_KEY_SIZE]) {
+    sm4_key_schedule(k, key->rk);
+    reverse_rk(key->rk, key->rk_dec);
+}
+
+void sm4_key_init_multi(sm4_key* keys, const uint8_t* k, size_t nkeys) {
+    uint32_t rk[SM4_KEY_BATCH][SM4_NUM_ROUNDS];
+    while (nkeys > 0) {
+        size_t n = nkeys < SM4_KEY_BATCH ? nkeys : SM4_KEY_BATCH;
+        sm4_key_schedule_multi(k, n, rk);
+        for (size_t i = 0; i < n; i++) {
+            memcpy(keys[i].rk, rk[i], sizeof(rk[i]));
+            reverse_rk(rk[i], keys[i].rk_dec);
+        }
+        keys += n;
+        k += 16 * n;
+        nkeys -= n;
+    }
+}
@@ -0,0 +1,178 @@
+#include "sm4.h"
+#include <string.h>
+#include <emmintrin.h>
+
+// ====== ģʽ =====
+// ECBCTRCBCܡCFBܸ֮û SM4_MODE_BATCH һ
+// sm4_encrypt_blocksǰںˣCBCܡCFBܡOFBֻ鴮С
+// к֧ in == out ԭز
+
+#define SM4_MODE_BATCH 256   // Ƭbs256һ256飬GFNIΪ16
+
+static inline void xor_block(uint8_t* out, const uint8_t* a, const uint8_t* b) {
+    for (int i = 0; i < 16; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+// out = a ^ bnֽڡֽдѭ-O2outصᱻ
+// ʽ16ֽ֧ out == a
+static inline void xor_bytes(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(x, y));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+// ÿֻһ飬ں˶ԵûƻҪӵÿֱT-table
+// ʽѡƬںʱ˵Ҫʱʵ֣Խںˣ
+static inline int serial_use_kernel() {
+    return sm4_get_kernel() == SM4_KERNEL_BITSLICE;
+}
+
+static inline void serial_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t in[16], uint8_t out[16], int use_kernel) {
+    if (use_kernel) {
+        sm4_encrypt_blocks(rk, in, out, 1);
+    }
+    else {
+        sm4_encrypt_block(in, out, rk);
+    }
+}
+
+// 128λ˼1
+static inline void ctr128_inc(uint8_t ctr[16]) {
+    for (int j = 15; j >= 0; j--) {
+        if (++ctr[j] != 0) break;
+    }
+}
+
+int sm4_ecb_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t len) {
+    if (len % SM4_BLOCK_SIZE != 0) {
+        return -1;
+    }
+    sm4_encrypt_blocks(rk, in, out, len / SM4_BLOCK_SIZE);
+    return 0;
+}
+
+int sm4_ecb_decrypt(const uint32_t rk_dec[SM4_NUM_ROUNDS], const uint8_t* in, uint8_t* out, size_t len) {
+    return sm4_ecb_encrypt(rk_dec, in, out, len);
+}
+
+int sm4_cbc_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    if (len % SM4_BLOCK_SIZE != 0) {
+        return -1;
+    }
+    int use_kernel = serial_use_kernel();
+    for (size_t off = 0; off < len; off += 16) {
+        xor_block(iv, iv, in + off);
+        serial_encrypt(rk, iv, iv, use_kernel);
+        memcpy(out + off, iv, 16);
+    }
+    return 0;
+}
+
+int sm4_cbc_decrypt(const uint32_t rk_dec[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    if (len % SM4_BLOCK_SIZE != 0) {
+        return -1;
+    }
+    uint8_t buf[SM4_MODE_BATCH * 16];
+    uint8_t prev[16], c[16];
+    memcpy(prev, iv, 16);
+
+    size_t nblocks = len / 16;
+    while (nblocks > 0) {
+        size_t n = nblocks < SM4_MODE_BATCH ? nblocks : SM4_MODE_BATCH;
+        sm4_encrypt_blocks(rk_dec, in, buf, n);
+        // ԭؽʱдoutḲģȱ浱ǰĿд
+        for (size_t i = 0; i < n; i++) {
+            memcpy(c, in + 16 * i, 16);
+            xor_block(out + 16 * i, buf + 16 * i, prev);
+            memcpy(prev, c, 16);
+        }
+        in += 16 * n;
+        out += 16 * n;
+        nblocks -= n;
+    }
+    memcpy(iv, prev, 16);
+    return 0;
+}
+
+void sm4_ctr_crypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t ctr[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    uint8_t buf[SM4_MODE_BATCH * 16];
+
+    while (len > 0) {
+        size_t n = (len + 15) / 16;
+        if (n > SM4_MODE_BATCH) n = SM4_MODE_BATCH;
+        for (size_t i = 0; i < n; i++) {
+            memcpy(buf + 16 * i, ctr, 16);
+            ctr128_inc(ctr);
+        }
+        sm4_encrypt_blocks(rk, buf, buf, n);
+
+        size_t bytes = n * 16 < len ? n * 16 : len;
+        xor_bytes(out, in, buf, bytes);
+        in += bytes;
+        out += bytes;
+        len -= bytes;
+    }
+}
+
+void sm4_ofb_crypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    int use_kernel = serial_use_kernel();
+    while (len > 0) {
+        serial_encrypt(rk, iv, iv, use_kernel);
+        size_t n = len < 16 ? len : 16;
+        xor_bytes(out, in, iv, n);
+        in += n;
+        out += n;
+        len -= n;
+    }
+}
+
+void sm4_cfb_encrypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    uint8_t ks[16];
+    int use_kernel = serial_use_kernel();
+    while (len > 0) {
+        serial_encrypt(rk, iv, ks, use_kernel);
+        size_t n = len < 16 ? len : 16;
+        xor_bytes(out, in, ks, n);
+        // ģһʱivʹ
+        memcpy(iv, out, n);
+        in += n;
+        out += n;
+        len -= n;
+    }
+}
+
+void sm4_cfb_decrypt(const uint32_t rk[SM4_NUM_ROUNDS], uint8_t iv[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    uint8_t buf[SM4_MODE_BATCH * 16];
+
+    while (len > 0) {
+        size_t n = (len + 15) / 16;
+        if (n > SM4_MODE_BATCH) n = SM4_MODE_BATCH;
+        size_t bytes = n * 16 < len ? n * 16 : len;
+
+        // iԿ E(C[i-1])ȫ֪һ
+        memcpy(buf, iv, 16);
+        memcpy(buf + 16, in, (n - 1) * 16);
+        size_t tail = bytes - (n - 1) * 16;
+        memcpy(iv, in + (n - 1) * 16, tail);
+        sm4_encrypt_blocks(rk, buf, buf, n);
+
+        xor_bytes(out, in, buf, bytes);
+        in += bytes;
+        out += bytes;
+        len -= bytes;
+    }
+}
@@ -0,0 +1,225 @@
+#include "sm4.h"
+#include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ====== ̳߳ =====
+// ߳ڵһβеʱפÿ̰߳󶨵̿õһCPUϣ
+// ֮ĵֻ軽̣߳ûд̵߳Ŀ񰴶αԭӼȡ
+// ߳ԼҲ㡣
+
+#if defined(__linux__)
+// ʱ̬ʼ߳ϣ¼ĿCPUϡ̵̳߳
+// ̳߳ص̣߳Ǹ߳ѱ󶨵CPUֱй̼߳ͬһCPU
+static cpu_set_t process_cpus;
+static const bool process_cpus_ok = sched_getaffinity(0, sizeof(process_cpus), &process_cpus) == 0;
+#endif
+
+// ѵǰ̰߳󶨵̿CPUеĵidx
+static void pin_current_thread(int idx) {
+#if defined(_WIN32)
+    DWORD_PTR proc_mask, sys_mask;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &proc_mask, &sys_mask)) return;
+    int n = 0;
+    for (int cpu = 0; cpu < (int)(8 * sizeof(DWORD_PTR)); cpu++) {
+        if (!(proc_mask & ((DWORD_PTR)1 << cpu))) continue;
+        if (n++ == idx) {
+            SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+            return;
+        }
+    }
+#elif defined(__linux__)
+    if (!process_cpus_ok) return;
+    const cpu_set_t& avail = process_cpus;
+    int count = CPU_COUNT(&avail);
+    if (count <= 0) return;
+    idx %= count;
+    for (int cpu = 0, n = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &avail)) continue;
+        if (n++ == idx) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+            return;
+        }
+    }
+#else
+    (void)idx;
+#endif
+}
+
+namespace {
+
+struct thread_pool {
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake, done;
+    uint64_t generation = 0;
+    bool stop = false;
+
+    // ǰ
+    sm4_range_fn fn = nullptr;
+    void* arg = nullptr;
+    size_t n = 0, grain = 1, nchunks = 0;
+    std::atomic<size_t> next_chunk{ 0 };
+    size_t busy = 0;   // δɵǰĹ߳
+
+    void run_chunks() {
+        for (;;) {
+            size_t c = next_chunk.fetch_add(1, std::memory_order_relaxed);
+            if (c >= nchunks) break;
+            size_t begin = c * grain;
+            size_t end = begin + grain < n ? begin + grain : n;
+            fn(arg, begin, end);
+        }
+    }
+
+    void worker_main(int idx);
+    void start(int nthreads);
+    void shutdown();
+};
+
+}
+
+// ǰִ߳вһΣ̣߳sm4_parallel_forвĵ̣߳
+// ʱǶ׵ֱӴִУpool_mutex
+static thread_local bool in_pool_worker = false;
+
+namespace {
+struct pool_region_guard {
+    bool saved = in_pool_worker;
+    pool_region_guard() { in_pool_worker = true; }
+    ~pool_region_guard() { in_pool_worker = saved; }
+};
+}
+
+void thread_pool::worker_main(int idx) {
+    in_pool_worker = true;
+    pin_current_thread(idx);
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(m);
+            wake.wait(lk, [&] { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+        }
+        run_chunks();
+        {
+            std::lock_guard<std::mutex> lk(m);
+            if (--busy == 0) done.notify_one();
+        }
+    }
+}
+
+// ߳0ⴴ nthreads-1 ߳
+void thread_pool::start(int nthreads) {
+    stop = false;
+    for (int i = 1; i < nthreads; i++) {
+        workers.emplace_back(&thread_pool::worker_main, this, i);
+    }
+}
+
+void thread_pool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+    workers.clear();
+}
+
+static std::mutex pool_mutex;       // ͬһʱֻһҲ߳
+static thread_pool* pool = nullptr;
+// 0ʾδȷȡĸڲǶ׵ sm4_ctr_crypt_mtҲѯ߳
+// ʱ߳pool_mutex
+static std::atomic<int> num_threads{ 0 };
+
+static int default_threads() {
+    const char* env = getenv("SM4_THREADS");
+    if (env && atoi(env) > 0) {
+        return atoi(env);
+    }
+    unsigned hc = std::thread::hardware_concurrency();
+    return hc ? (int)hc : 1;
+}
+
+int sm4_get_num_threads(void) {
+    int n = num_threads.load();
+    if (n == 0) {
+        num_threads.compare_exchange_strong(n, default_threads());
+        n = num_threads.load();
+    }
+    return n;
+}
+
+void sm4_set_num_threads(int n) {
+    std::lock_guard<std::mutex> lk(pool_mutex);
+    if (n <= 0) n = default_threads();
+    if (n == num_threads) return;
+    // ߳仯ʱپ̳߳أ´ʹʱ߳ؽ
+    if (pool) {
+        pool->shutdown();
+        delete pool;
+        pool = nullptr;
+    }
+    num_threads = n;
+}
+
+void sm4_parallel_for(size_t n, size_t grain, sm4_range_fn fn, void* arg) {
+    if (n == 0) return;
+    if (grain == 0) grain = 1;
+    size_t nchunks = (n + grain - 1) / grain;
+
+    // ֻһλڹ߳Ƕ׵ʱֱӴִ
+    if (nchunks == 1 || in_pool_worker) {
+        for (size_t b = 0; b < n; b += grain) {
+            fn(arg, b, b + grain < n ? b + grain : n);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk_pool(pool_mutex);
+    pool_region_guard region;
+    int nthreads = sm4_get_num_threads();
+    if (nthreads == 1) {
+        for (size_t b = 0; b < n; b += grain) {
+            fn(arg, b, b + grain < n ? b + grain : n);
+        }
+        return;
+    }
+    if (!pool) {
+        pool = new thread_pool;
+        pool->start(nthreads);
+    }
+
+    thread_pool& p = *pool;
+    {
+        std::lock_guard<std::mutex> lk(p.m);
+        p.fn = fn;
+        p.arg = arg;
+        p.n = n;
+        p.grain = grain;
+        p.nchunks = nchunks;
+        p.next_chunk.store(0, std::memory_order_relaxed);
+        p.busy = p.workers.size();
+        p.generation++;
+    }
+    p.wake.notify_all();
+    p.run_chunks();
+
+    std::unique_lock<std::mutex> lk(p.m);
+    p.done.wait(lk, [&] { return p.busy == 0; });
+}
@@ -0,0 +1,186 @@
+#include "sm4.h"
+#include <string.h>
+#include <immintrin.h>
+
+// ====== XTSģʽ =====
+// IEEE 1619 ṹjtweak T_j = E_K2()  ^jC_j = E_K1(P_j ^ T_j) ^ T_j
+// һtweakȫãһ𽻸 sm4_encrypt_blocksǰںˣ
+
+#define SM4_XTS_BATCH 256   // ÿ256飬һ4 KiB
+
+// tweak˦128λС1λλʱֽ0x87
+static inline __m128i xts_mul_alpha(__m128i t) {
+    __m128i c = _mm_shuffle_epi32(t, 0x13);   // 63λ127λƵλ
+    c = _mm_srai_epi32(c, 31);
+    c = _mm_and_si128(c, _mm_setr_epi32(0x87, 0, 1, 0));
+    return _mm_xor_si128(_mm_add_epi64(t, t), c);
+}
+
+// tweakͬʱ˦^81ֽڣƳֽc0x87c ^ c<<1 ^ c<<2 ^ c<<7صλ
+SM4_TARGET("avx2")
+static inline __m256i xts_mul_alpha8_avx2(__m256i t) {
+    __m256i c = _mm256_srli_si256(t, 15);
+    c = _mm256_xor_si256(_mm256_xor_si256(c, _mm256_slli_epi64(c, 1)),
+        _mm256_xor_si256(_mm256_slli_epi64(c, 2), _mm256_slli_epi64(c, 7)));
+    return _mm256_xor_si256(_mm256_slli_si256(t, 1), c);
+}
+
+// tw[0]tw[1..n-1]˦
+static void xts_tweaks_sse(uint8_t* tw, size_t n) {
+    __m128i t = _mm_loadu_si128((const __m128i*)tw);
+    for (size_t j = 1; j < n; j++) {
+        t = xts_mul_alpha(t);
+        _mm_storeu_si128((__m128i*)(tw + 16 * j), t);
+    }
+}
+
+// ǰ8ɣ֮ tw[j] = tw[j-8]^8ÿ
+SM4_TARGET("avx2")
+static void xts_tweaks_avx2(uint8_t* tw, size_t n) {
+    size_t j = n < 8 ? n : 8;
+    xts_tweaks_sse(tw, j);
+    for (; j + 2 <= n; j += 2) {
+        __m256i t = _mm256_loadu_si256((const __m256i*)(tw + 16 * (j - 8)));
+        _mm256_storeu_si256((__m256i*)(tw + 16 * j), xts_mul_alpha8_avx2(t));
+    }
+    if (j < n) {
+        __m128i t = _mm_loadu_si128((const __m128i*)(tw + 16 * (j - 1)));
+        _mm_storeu_si128((__m128i*)(tw + 16 * j), xts_mul_alpha(t));
+    }
+}
+
+static void xts_tweaks(uint8_t* tw, size_t n) {
+    // AVX2ں˿ü˵CPUͲϵͳ֧AVX2
+    static const int use_avx2 = sm4_kernel_supported(SM4_KERNEL_AVX2);
+    if (use_avx2) {
+        xts_tweaks_avx2(tw, n);
+    }
+    else {
+        xts_tweaks_sse(tw, n);
+    }
+}
+
+static inline void xor_blocks(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n) {
+    for (size_t i = 0; i < 16 * n; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+// out = E(in ^ tw) ^ twnһνںˣ֧ in == out
+static void xts_blocks(const uint32_t rk[SM4_NUM_ROUNDS], const uint8_t* tw,
+    const uint8_t* in, uint8_t* out, size_t n) {
+    xor_blocks(out, in, tw, n);
+    sm4_encrypt_blocks(rk, out, out, n);
+    xor_blocks(out, out, tw, n);
+}
+
+// һݵԪt0ΪѼܵĳʼtweak E_K2(i)
+static void xts_unit(const sm4_xts_key* key, const uint8_t t0[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len, int enc) {
+    const uint32_t* rk = enc ? key->rk1 : key->rk1_dec;
+    alignas(32) uint8_t tw[(SM4_XTS_BATCH + 1) * 16];
+
+    size_t tail = len % 16;
+    // вһβʱһȡ
+    size_t nbulk = len / 16 - (tail ? 1 : 0);
+
+    memcpy(tw, t0, 16);
+    while (nbulk > 0) {
+        size_t n = nbulk < SM4_XTS_BATCH ? nbulk : SM4_XTS_BATCH;
+        // һΪһʼtweak
+        xts_tweaks(tw, n + 1);
+        xts_blocks(rk, tw, in, out, n);
+        memcpy(tw, tw + 16 * n, 16);
+        in += 16 * n;
+        out += 16 * n;
+        nbulk -= n;
+    }
+
+    if (tail) {
+        // ȡtwΪT_{m-1}nextΪT_m
+        // T_{m-1}飬T_m
+        uint8_t next[16], cc[16], pp[16];
+        _mm_storeu_si128((__m128i*)next, xts_mul_alpha(_mm_loadu_si128((const __m128i*)tw)));
+        const uint8_t* ta = enc ? tw : next;
+        const uint8_t* tb = enc ? next : tw;
+
+        xts_blocks(rk, ta, in, cc, 1);
+        // β/Ĳccĺ벿֣ȶβд֤ԭزȷ
+        memcpy(pp, in + 16, tail);
+        memcpy(pp + tail, cc + tail, 16 - tail);
+        memcpy(out + 16, cc, tail);
+        xts_blocks(rk, tb, pp, out, 1);
+    }
+}
+
+int sm4_xts_set_key(sm4_xts_key* key, const uint8_t k[2 * SM4_KEY_SIZE]) {
+    // IEEE 1619 ҪK1K2ͬ
+    if (memcmp(k, k + SM4_KEY_SIZE, SM4_KEY_SIZE) == 0) {
+        return -1;
+    }
+    sm4_key_schedule(k, key->rk1);
+    sm4_key_schedule_dec(k, key->rk1_dec);
+    sm4_key_schedule(k + SM4_KEY_SIZE, key->rk2);
+    return 0;
+}
+
+static int xts_crypt(const sm4_xts_key* key, const uint8_t tweak[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len, int enc) {
+    if (len < SM4_BLOCK_SIZE) {
+        return -1;
+    }
+    uint8_t t0[16];
+    sm4_encrypt_blocks(key->rk2, tweak, t0, 1);
+    xts_unit(key, t0, in, out, len, enc);
+    return 0;
+}
+
+int sm4_xts_encrypt(const sm4_xts_key* key, const uint8_t tweak[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    return xts_crypt(key, tweak, in, out, len, 1);
+}
+
+int sm4_xts_decrypt(const sm4_xts_key* key, const uint8_t tweak[SM4_BLOCK_SIZE],
+    const uint8_t* in, uint8_t* out, size_t len) {
+    return xts_crypt(key, tweak, in, out, len, 0);
+}
+
+// ÿţ128λСˣһK2ܵõʼtweak
+static int xts_crypt_sectors(const sm4_xts_key* key, uint64_t sector, size_t sector_size,
+    const uint8_t* in, uint8_t* out, size_t nsectors, int enc) {
+    if (sector_size < SM4_BLOCK_SIZE) {
+        return -1;
+    }
+    uint8_t t0[SM4_XTS_BATCH * 16];
+
+    while (nsectors > 0) {
+        size_t n = nsectors < SM4_XTS_BATCH ? nsectors : SM4_XTS_BATCH;
+        memset(t0, 0, 16 * n);
+        for (size_t s = 0; s < n; s++) {
+            uint64_t no = sector + s;
+            for (int b = 0; b < 8; b++) {
+                t0[16 * s + b] = (uint8_t)(no >> (8 * b));
+            }
+        }
+        sm4_encrypt_blocks(key->rk2, t0, t0, n);
+
+        for (size_t s = 0; s < n; s++) {
+            xts_unit(key, t0 + 16 * s, in, out, sector_size, enc);
+            in += sector_size;
+            out += sector_size;
+        }
+        sector += n;
+        nsectors -= n;
+    }
+    return 0;
+}
+
+int sm4_xts_encrypt_sectors(const sm4_xts_key* key, uint64_t sector, size_t sector_size,
+    const uint8_t* in, uint8_t* out, size_t nsectors) {
+    return xts_crypt_sectors(key, sector, sector_size, in, out, nsectors, 1);
+}
+
+int sm4_xts_decrypt_sectors(const sm4_xts_key* key, uint64_t sector, size_t sector_size,
+    const uint8_t* in, uint8_t* out, size_t nsectors) {
+    return xts_crypt_sectors(key, sector, sector_size, in, out, nsectors, 0);
+}
@@ -5,6 +5,8 @@
 #include <iomanip>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
+#include <cstdint>
 
 using namespace std;
 
@@ -27,34 +29,73 @@ public:
         0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a
     };
 
-    static vector<uint8_t> hash(const vector<uint8_t>& message) {
-        uint64_t bit_len = message.size() * 8;
-        size_t pad_len = ((message.size() + 8 + 1 + 63) / 64) * 64;
-        vector<uint8_t> padded(pad_len, 0);
-        copy(message.begin(), message.end(), padded.begin());
-        padded[message.size()] = 0x80;
+    // 流式接口：update可多次调用、任意长度，整块直接在调用者内存上压缩，
+    // 只有不足一块的部分进入64字节缓冲；final只填充最后1~2块
+    SM3() {
+        copy(begin(IV), end(IV), begin(V_));
+    }
 
-        for (int i = 0; i < 8; ++i) {
-            padded[pad_len - 8 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+    void update(const uint8_t* data, size_t len) {
+        if (len == 0) return;
+        total_ += len;
+
+        // 先补满上次剩下的部分块
+        if (buf_len_ > 0) {
+            size_t n = min(sizeof(buf_) - buf_len_, len);
+            memcpy(buf_ + buf_len_, data, n);
+            buf_len_ += n;
+            data += n;
+            len -= n;
+            if (buf_len_ < sizeof(buf_)) return;
+            compress(V_, buf_);
+            buf_len_ = 0;
         }
 
-        uint32_t V[8];
-        copy(begin(IV), end(IV), begin(V));
+        for (; len >= 64; data += 64, len -= 64) {
+            compress(V_, data);
+        }
 
-        for (size_t i = 0; i < pad_len; i += 64) {
-            compress(V, padded.data() + i);
+        if (len > 0) {
+            memcpy(buf_, data, len);
+            buf_len_ = len;
+        }
+    }
+
+    void update(const vector<uint8_t>& data) {
+        update(data.data(), data.size());
+    }
+
+    // 填充并输出摘要，之后不能再update
+    vector<uint8_t> final() {
+        uint64_t bit_len = total_ * 8;
+        buf_[buf_len_++] = 0x80;
+        if (buf_len_ > 56) {
+            memset(buf_ + buf_len_, 0, 64 - buf_len_);
+            compress(V_, buf_);
+            buf_len_ = 0;
+        }
+        memset(buf_ + buf_len_, 0, 56 - buf_len_);
+        for (int i = 0; i < 8; ++i) {
+            buf_[56 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
         }
+        compress(V_, buf_);
 
         vector<uint8_t> digest(32);
         for (int i = 0; i < 8; ++i) {
-            digest[i * 4] = (V[i] >> 24) & 0xFF;
-            digest[i * 4 + 1] = (V[i] >> 16) & 0xFF;
-            digest[i * 4 + 2] = (V[i] >> 8) & 0xFF;
-            digest[i * 4 + 3] = V[i] & 0xFF;
+            digest[i * 4] = (V_[i] >> 24) & 0xFF;
+            digest[i * 4 + 1] = (V_[i] >> 16) & 0xFF;
+            digest[i * 4 + 2] = (V_[i] >> 8) & 0xFF;
+            digest[i * 4 + 3] = V_[i] & 0xFF;
         }
         return digest;
     }
 
+    static vector<uint8_t> hash(const vector<uint8_t>& message) {
+        SM3 ctx;
+        ctx.update(message);
+        return ctx.final();
+    }
+
 private:
     static inline uint32_t ROTL(uint32_t x, int n) {
         return (x << n) | (x >> (32 - n));
@@ -115,6 +156,11 @@ private:
         V[0] ^= A; V[1] ^= B; V[2] ^= C; V[3] ^= D;
         V[4] ^= E; V[5] ^= F; V[6] ^= G; V[7] ^= H;
     }
+
+    uint32_t V_[8];          // 链接变量
+    uint64_t total_ = 0;     // 已输入的字节数
+    uint8_t buf_[64];        // 不足一块的数据
+    size_t buf_len_ = 0;
 };
 
 // Merkle树实现
@@ -129,9 +175,7 @@ public:
         // 计算叶子节点哈希
         vector<vector<uint8_t>> current_level;
         for (const auto& leaf : leaves) {
-            vector<uint8_t> prefixed_leaf = { 0x00 };
-            prefixed_leaf.insert(prefixed_leaf.end(), leaf.begin(), leaf.end());
-            current_level.push_back(SM3::hash(prefixed_leaf));
+            current_level.push_back(hash_leaf(leaf));
         }
         levels_.push_back(current_level);
 
@@ -145,12 +189,7 @@ public:
             }
 
             for (size_t i = 0; i < current_level.size(); i += 2) {
-                vector<uint8_t> prefixed_node = { 0x01 };
-                prefixed_node.insert(prefixed_node.end(),
-                    current_level[i].begin(), current_level[i].end());
-                prefixed_node.insert(prefixed_node.end(),
-                    current_level[i + 1].begin(), current_level[i + 1].end());
-                next_level.push_back(SM3::hash(prefixed_node));
+                next_level.push_back(hash_node(current_level[i], current_level[i + 1]));
             }
 
             levels_.push_back(next_level);
@@ -190,32 +229,19 @@ public:
         const vector<vector<uint8_t>>& proof,
         size_t leaf_index) {
         // 1. 计算叶子节点的哈希（添加前缀0x00）
-        vector<uint8_t> current_hash;
-        current_hash.reserve(1 + leaf_data.size());
-        current_hash.push_back(0x00);
-        current_hash.insert(current_hash.end(), leaf_data.begin(), leaf_data.end());
-        current_hash = SM3::hash(current_hash);
+        vector<uint8_t> current_hash = hash_leaf(leaf_data);
 
         // 2. 沿着证明路径向上计算
         for (size_t i = 0; i < proof.size(); ++i) {
-            vector<uint8_t> combined;
-            combined.reserve(1 + current_hash.size() + proof[i].size());
-            combined.push_back(0x01); // 内部节点前缀
-
             // 根据索引的当前位决定左右顺序
             if ((leaf_index >> i) & 1) {
                 // 当前是右节点，兄弟在左边
-                combined.insert(combined.end(), proof[i].begin(), proof[i].end());
-                combined.insert(combined.end(), current_hash.begin(), current_hash.end());
+                current_hash = hash_node(proof[i], current_hash);
             }
             else {
                 // 当前是左节点，兄弟在右边
-                combined.insert(combined.end(), current_hash.begin(), current_hash.end());
-                combined.insert(combined.end(), proof[i].begin(), proof[i].end());
+                current_hash = hash_node(current_hash, proof[i]);
             }
-
-            // 计算父节点哈希
-            current_hash = SM3::hash(combined);
         }
 
         // 3. 比较最终计算结果与根哈希
@@ -223,6 +249,25 @@ public:
     }
 
 private:
+    // 叶子节点 SM3(0x00 || data)，前缀和数据依次输入哈希上下文，不拼接副本
+    static vector<uint8_t> hash_leaf(const vector<uint8_t>& data) {
+        static const uint8_t prefix = 0x00;
+        SM3 ctx;
+        ctx.update(&prefix, 1);
+        ctx.update(data);
+        return ctx.final();
+    }
+
+    // 内部节点 SM3(0x01 || left || right)
+    static vector<uint8_t> hash_node(const vector<uint8_t>& left, const vector<uint8_t>& right) {
+        static const uint8_t prefix = 0x01;
+        SM3 ctx;
+        ctx.update(&prefix, 1);
+        ctx.update(left);
+        ctx.update(right);
+        return ctx.final();
+    }
+
     vector<vector<vector<uint8_t>>> levels_;
     vector<uint8_t> root_;
 };
@@ -2,8 +2,10 @@
 #include <vector>
 #include <string>
 #include <iomanip>
+#include <algorithm>
 #include <cstring>
 #include <cstdint>
+#include <stdexcept>
 
 using namespace std;
 
@@ -26,76 +28,102 @@ public:
         0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a
     };
 
-    static vector<uint8_t> hash(const vector<uint8_t>& message) {
-        uint64_t bit_len = message.size() * 8;
-        size_t pad_len = ((message.size() + 8 + 1 + 63) / 64) * 64;
-        vector<uint8_t> padded(pad_len, 0);
-        copy(message.begin(), message.end(), padded.begin());
-        padded[message.size()] = 0x80;
+    // 流式接口：update可多次调用、任意长度，整块直接在调用者内存上压缩，
+    // 只有不足一块的部分进入64字节缓冲；final只填充最后1~2块
+    SM3() {
+        copy(begin(IV), end(IV), begin(V_));
+    }
 
-        for (int i = 0; i < 8; ++i) {
-            padded[pad_len - 8 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+    void update(const uint8_t* data, size_t len) {
+        if (len == 0) return;
+        total_ += len;
+
+        // 先补满上次剩下的部分块
+        if (buf_len_ > 0) {
+            size_t n = min(sizeof(buf_) - buf_len_, len);
+            memcpy(buf_ + buf_len_, data, n);
+            buf_len_ += n;
+            data += n;
+            len -= n;
+            if (buf_len_ < sizeof(buf_)) return;
+            compress(V_, buf_);
+            buf_len_ = 0;
         }
 
-        uint32_t V[8];
-        copy(begin(IV), end(IV), begin(V));
+        for (; len >= 64; data += 64, len -= 64) {
+            compress(V_, data);
+        }
 
-        for (size_t i = 0; i < pad_len; i += 64) {
-            compress(V, padded.data() + i);
+        if (len > 0) {
+            memcpy(buf_, data, len);
+            buf_len_ = len;
         }
+    }
+
+    void update(const vector<uint8_t>& data) {
+        update(data.data(), data.size());
+    }
+
+    // 填充并输出摘要，之后不能再update
+    vector<uint8_t> final() {
+        uint64_t bit_len = total_ * 8;
+        buf_[buf_len_++] = 0x80;
+        if (buf_len_ > 56) {
+            memset(buf_ + buf_len_, 0, 64 - buf_len_);
+            compress(V_, buf_);
+            buf_len_ = 0;
+        }
+        memset(buf_ + buf_len_, 0, 56 - buf_len_);
+        for (int i = 0; i < 8; ++i) {
+            buf_[56 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+        }
+        compress(V_, buf_);
 
         vector<uint8_t> digest(32);
         for (int i = 0; i < 8; ++i) {
-            digest[i * 4] = (V[i] >> 24) & 0xFF;
-            digest[i * 4 + 1] = (V[i] >> 16) & 0xFF;
-            digest[i * 4 + 2] = (V[i] >> 8) & 0xFF;
-            digest[i * 4 + 3] = V[i] & 0xFF;
+            digest[i * 4] = (V_[i] >> 24) & 0xFF;
+            digest[i * 4 + 1] = (V_[i] >> 16) & 0xFF;
+            digest[i * 4 + 2] = (V_[i] >> 8) & 0xFF;
+            digest[i * 4 + 3] = V_[i] & 0xFF;
         }
         return digest;
     }
 
+    static vector<uint8_t> hash(const vector<uint8_t>& message) {
+        SM3 ctx;
+        ctx.update(message);
+        return ctx.final();
+    }
+
+    // 从分组边界处的链接变量继续：cv为前total字节压缩后的状态，字节序与摘要相同，
+    // total必须是64的倍数。前缀相同的大量消息也可以对前缀update后直接复制SM3对象
+    static SM3 resume(const vector<uint8_t>& cv, uint64_t total) {
+        if (cv.size() != 32 || total % 64 != 0) {
+            throw invalid_argument("SM3::resume: bad chaining value or length");
+        }
+        SM3 ctx;
+        for (int i = 0; i < 8; ++i) {
+            ctx.V_[i] = ((uint32_t)cv[4 * i] << 24) |
+                (cv[4 * i + 1] << 16) |
+                (cv[4 * i + 2] << 8) |
+                cv[4 * i + 3];
+        }
+        ctx.total_ = total;
+        return ctx;
+    }
+
     // 长度扩展攻击函数
     static vector<uint8_t> length_extension_attack(
         const vector<uint8_t>& original_hash,
         const vector<uint8_t>& extension,
         uint64_t original_length
     ) {
-        // 从原始哈希恢复内部状态
-        uint32_t V[8];
-        for (int i = 0; i < 8; ++i) {
-            V[i] = (original_hash[4 * i] << 24) |
-                (original_hash[4 * i + 1] << 16) |
-                (original_hash[4 * i + 2] << 8) |
-                original_hash[4 * i + 3];
-        }
+        // 原哈希就是原始消息填充后的链接变量，扩展部分的长度字段从填充后的长度接着计数
+        SM3 ctx = resume(original_hash, ((original_length + 1 + 8 + 63) / 64) * 64);
 
-        // 计算原始消息的填充
-        uint64_t original_padded_len = ((original_length + 1 + 8 + 63) / 64) * 64;
-        uint64_t total_bit_len = (original_padded_len + extension.size()) * 8;
-
-        // 对新消息进行填充
-        size_t pad_len = ((extension.size() + 1 + 8 + 63) / 64) * 64;
-        vector<uint8_t> padded(pad_len, 0);
-        copy(extension.begin(), extension.end(), padded.begin());
-        padded[extension.size()] = 0x80;
-        for (int i = 0; i < 8; ++i) {
-            padded[pad_len - 8 + i] = (total_bit_len >> (56 - i * 8)) & 0xFF;
-        }
-
-        // 使用恢复的状态继续计算
-        for (size_t i = 0; i < pad_len; i += 64) {
-            compress(V, padded.data() + i);
-        }
-
-        // 生成伪造哈希
-        vector<uint8_t> forged_hash(32);
-        for (int i = 0; i < 8; ++i) {
-            forged_hash[4 * i] = (V[i] >> 24) & 0xFF;
-            forged_hash[4 * i + 1] = (V[i] >> 16) & 0xFF;
-            forged_hash[4 * i + 2] = (V[i] >> 8) & 0xFF;
-            forged_hash[4 * i + 3] = V[i] & 0xFF;
-        }
-        return forged_hash;
+        // 使用恢复的状态继续计算，生成伪造哈希
+        ctx.update(extension);
+        return ctx.final();
     }
 
 private:
@@ -158,6 +186,11 @@ private:
         V[0] ^= A; V[1] ^= B; V[2] ^= C; V[3] ^= D;
         V[4] ^= E; V[5] ^= F; V[6] ^= G; V[7] ^= H;
     }
+
+    uint32_t V_[8];          // 链接变量
+    uint64_t total_ = 0;     // 已输入的字节数
+    uint8_t buf_[64];        // 不足一块的数据
+    size_t buf_len_ = 0;
 };
 
 // 辅助函数
@@ -1,10 +1,25 @@
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <cstdio>
 #include <iomanip>
 #include <immintrin.h>
 #include <chrono>
 #include <cassert>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// 指定函数的目标指令集，同一个二进制可以同时包含AVX2和AVX-512的内核（MSVC不需要）
+#if defined(__GNUC__) || defined(__clang__)
+#define SM3_TARGET(x) __attribute__((target(x)))
+#else
+#define SM3_TARGET(x)
+#endif
 
 // 常量定义
 constexpr uint32_t IV[] = {
@@ -23,6 +38,18 @@ constexpr uint32_t T[64] = {
     0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a
 };
 
+// ROTL(T[j], j % 32)，各轮的常量只和j有关，编译期算好
+struct RotatedT {
+    uint32_t v[64];
+    constexpr RotatedT() : v() {
+        for (int j = 0; j < 64; ++j) {
+            int n = j % 32;
+            v[j] = n == 0 ? T[j] : (T[j] << n) | (T[j] >> (32 - n));
+        }
+    }
+};
+constexpr RotatedT T_ROT;
+
 // 工具函数
 inline uint32_t ROTL(uint32_t x, int n) {
     return (x << n) | (x >> (32 - n));
@@ -54,8 +81,8 @@ void MessageExpansion(const uint8_t block[64], uint32_t W[68], uint32_t W1[64])
     }
 }
 
-// 压缩函数
-void Compression(uint32_t V[8], const uint8_t block[64]) {
+// 参考实现：先算出全部W/W1，再逐轮计算（用于验证和性能对比）
+void Compression_Ref(uint32_t V[8], const uint8_t block[64]) {
     uint32_t W[68], W1[64];
     MessageExpansion(block, W, W1);
 
@@ -63,7 +90,7 @@ void Compression(uint32_t V[8], const uint8_t block[64]) {
     uint32_t E = V[4], F = V[5], G = V[6], H = V[7];
 
     for (int j = 0; j < 64; ++j) {
-        uint32_t SS1 = ROTL((ROTL(A, 12) + E + ROTL(T[j], j % 32)), 7);
+        uint32_t SS1 = ROTL((ROTL(A, 12) + E + T_ROT.v[j]), 7);
         uint32_t SS2 = SS1 ^ ROTL(A, 12);
         uint32_t TT1 = FF(A, B, C, j) + D + SS2 + W1[j];
         uint32_t TT2 = GG(E, F, G, j) + H + SS1 + W[j];
@@ -76,127 +103,635 @@ void Compression(uint32_t V[8], const uint8_t block[64]) {
     V[4] ^= E; V[5] ^= F; V[6] ^= G; V[7] ^= H;
 }
 
+// ====== 单条消息的压缩函数 =====
+// 单条消息无法多缓冲，只能缩短每轮的关键路径：
+// - 各轮常量直接查T_ROT，不在轮内做 ROTL(T[j], j % 32)
+// - 0~15轮和16~63轮分开，布尔函数没有 j < 16 的分支
+// - 不预先算出全部W[68]/W1[64]：W[i]依赖W[i-3]，消息扩展用SSE2一次算3个字，
+//   穿插在轮函数之间，只领先轮函数4个字；W1[j] = W[j] ^ W[j+4] 在轮内现算
+
+// 第16~63轮的布尔函数：FF为多数函数，GG为选择函数
+inline uint32_t FF1(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | ((x | y) & z); }
+inline uint32_t GG1(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+
+// 一轮压缩，ff/gg为本轮的布尔函数值，t为ROTL(T[j], j % 32)
+inline void Round(uint32_t& A, uint32_t& B, uint32_t& C, uint32_t& D,
+    uint32_t& E, uint32_t& F, uint32_t& G, uint32_t& H,
+    uint32_t ff, uint32_t gg, uint32_t Wj, uint32_t Wj4, uint32_t t) {
+    uint32_t A12 = ROTL(A, 12);
+    uint32_t SS1 = ROTL(A12 + E + t, 7);
+    uint32_t SS2 = SS1 ^ A12;
+    uint32_t TT1 = ff + D + SS2 + (Wj ^ Wj4);
+    uint32_t TT2 = gg + H + SS1 + Wj;
+
+    D = C; C = ROTL(B, 9); B = A; A = TT1;
+    H = G; G = ROTL(F, 19); F = E; E = P0(TT2);
+}
+
+inline __m128i _mm_rotl_epi32(__m128i x, int n) {
+    return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+}
+
+// W[i..i+2] = P1(W[i-16] ^ W[i-9] ^ ROTL(W[i-3], 15)) ^ ROTL(W[i-13], 7) ^ W[i-6]。
+// 按4个字存储，第4个字无意义（W[72]留有余量），下一次扩展时被覆盖。
+// w3的第4道读W[i]，为上一次扩展写入的无意义字，首次扩展前W[16]须先置0
+inline void Expand3(uint32_t* W, int i) {
+    __m128i w16 = _mm_loadu_si128((const __m128i*)&W[i - 16]);
+    __m128i w13 = _mm_loadu_si128((const __m128i*)&W[i - 13]);
+    __m128i w9 = _mm_loadu_si128((const __m128i*)&W[i - 9]);
+    __m128i w6 = _mm_loadu_si128((const __m128i*)&W[i - 6]);
+    __m128i w3 = _mm_loadu_si128((const __m128i*)&W[i - 3]);
+    __m128i x = _mm_xor_si128(_mm_xor_si128(w16, w9), _mm_rotl_epi32(w3, 15));
+    x = _mm_xor_si128(_mm_xor_si128(x, _mm_rotl_epi32(x, 15)), _mm_rotl_epi32(x, 23));
+    x = _mm_xor_si128(_mm_xor_si128(x, _mm_rotl_epi32(w13, 7)), w6);
+    _mm_storeu_si128((__m128i*)&W[i], x);
+}
+
+#define ROUND1(j) Round(A, B, C, D, E, F, G, H, A ^ B ^ C, E ^ F ^ G, W[j], W[(j) + 4], T_ROT.v[j])
+#define ROUND2(j) Round(A, B, C, D, E, F, G, H, FF1(A, B, C), GG1(E, F, G), W[j], W[(j) + 4], T_ROT.v[j])
+
+// 压缩函数
+void Compression(uint32_t V[8], const uint8_t block[64]) {
+    uint32_t W[72];
+    for (int i = 0; i < 16; ++i) {
+        W[i] = ((uint32_t)block[i * 4] << 24) | (block[i * 4 + 1] << 16)
+            | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    W[16] = 0;   // Expand3(W, 16) 的w3第4道会读到它
+
+    uint32_t A = V[0], B = V[1], C = V[2], D = V[3];
+    uint32_t E = V[4], F = V[5], G = V[6], H = V[7];
+
+    // 第j轮用到W[j+4]，每次扩展前已有的字刚好够用
+    for (int j = 0; j < 12; ++j) {
+        ROUND1(j);
+    }
+    Expand3(W, 16);
+    ROUND1(12); ROUND1(13); ROUND1(14);
+    Expand3(W, 19);
+    ROUND1(15); ROUND2(16); ROUND2(17);
+    for (int j = 18; j < 63; j += 3) {
+        Expand3(W, j + 4);
+        ROUND2(j); ROUND2(j + 1); ROUND2(j + 2);
+    }
+    Expand3(W, 67);
+    ROUND2(63);
+
+    V[0] ^= A; V[1] ^= B; V[2] ^= C; V[3] ^= D;
+    V[4] ^= E; V[5] ^= F; V[6] ^= G; V[7] ^= H;
+}
+
+#undef ROUND1
+#undef ROUND2
+
+// ====== 流式接口 =====
+// init → update（可多次，任意长度）→ final。整块直接在调用者内存上压缩，
+// 只有不足一块的部分进入64字节缓冲，final只填充最后1~2块，内存占用固定。
+
+struct SM3_CTX {
+    uint32_t V[8];        // 链接变量
+    uint64_t total;       // 已输入的字节数
+    uint8_t buf[64];      // 不足一块的数据
+    size_t buf_len;
+};
+
+void SM3_Init(SM3_CTX* ctx) {
+    memcpy(ctx->V, IV, sizeof(IV));
+    ctx->total = 0;
+    ctx->buf_len = 0;
+}
+
+void SM3_Update(SM3_CTX* ctx, const uint8_t* data, size_t len) {
+    if (len == 0) return;
+    ctx->total += len;
+
+    // 先补满上次剩下的部分块
+    if (ctx->buf_len > 0) {
+        size_t n = std::min(64 - ctx->buf_len, len);
+        memcpy(ctx->buf + ctx->buf_len, data, n);
+        ctx->buf_len += n;
+        data += n;
+        len -= n;
+        if (ctx->buf_len < 64) return;
+        Compression(ctx->V, ctx->buf);
+        ctx->buf_len = 0;
+    }
+
+    for (; len >= 64; data += 64, len -= 64) {
+        Compression(ctx->V, data);
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buf, data, len);
+        ctx->buf_len = len;
+    }
+}
+
+// 填充并输出摘要，之后ctx需要重新init
+void SM3_Final(SM3_CTX* ctx, uint8_t digest[32]) {
+    uint64_t bit_len = ctx->total * 8;
+    ctx->buf[ctx->buf_len++] = 0x80;
+    if (ctx->buf_len > 56) {
+        memset(ctx->buf + ctx->buf_len, 0, 64 - ctx->buf_len);
+        Compression(ctx->V, ctx->buf);
+        ctx->buf_len = 0;
+    }
+    memset(ctx->buf + ctx->buf_len, 0, 56 - ctx->buf_len);
+    for (int i = 0; i < 8; ++i) {
+        ctx->buf[56 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+    }
+    Compression(ctx->V, ctx->buf);
+
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = (ctx->V[i] >> 24) & 0xFF;
+        digest[i * 4 + 1] = (ctx->V[i] >> 16) & 0xFF;
+        digest[i * 4 + 2] = (ctx->V[i] >> 8) & 0xFF;
+        digest[i * 4 + 3] = ctx->V[i] & 0xFF;
+    }
+}
+
 // SM3哈希主函数
 std::vector<uint8_t> SM3(const uint8_t* msg, size_t len) {
-    // 消息填充
-    uint64_t bit_len = len * 8;
-    size_t pad_len = ((len + 8 + 1 + 63) / 64) * 64;
-    std::vector<uint8_t> padded(pad_len, 0);
-    memcpy(padded.data(), msg, len);
-    padded[len] = 0x80;
+    SM3_CTX ctx;
+    SM3_Init(&ctx);
+    SM3_Update(&ctx, msg, len);
+
+    std::vector<uint8_t> digest(32);
+    SM3_Final(&ctx, digest.data());
+    return digest;
+}
+
+// ====== 中间状态（midstate）=====
+// 大量消息有相同前缀时（如 SM3(Z_A || M)、带域分隔前缀的哈希），前缀只需压缩一次：
+// 对前缀update后的上下文就是中间状态，每条消息复制一份再继续update/final。
+// SM3_CTX不含指针，进程内直接赋值即可复制；要缓存到文件或其他进程时用Export/Import。
+
+// 链接变量32字节 + 字节数8字节 + 缓冲长度1字节 + 缓冲64字节，整数均为大端
+#define SM3_STATE_SIZE 105
+
+void SM3_Export(const SM3_CTX* ctx, uint8_t out[SM3_STATE_SIZE]) {
+    for (int i = 0; i < 8; ++i) {
+        out[i * 4] = (ctx->V[i] >> 24) & 0xFF;
+        out[i * 4 + 1] = (ctx->V[i] >> 16) & 0xFF;
+        out[i * 4 + 2] = (ctx->V[i] >> 8) & 0xFF;
+        out[i * 4 + 3] = ctx->V[i] & 0xFF;
+    }
     for (int i = 0; i < 8; ++i) {
-        padded[pad_len - 8 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+        out[32 + i] = (ctx->total >> (56 - i * 8)) & 0xFF;
     }
+    out[40] = (uint8_t)ctx->buf_len;
+    // 缓冲中未使用的部分输出0，相同的状态总是得到相同的字节
+    memcpy(out + 41, ctx->buf, ctx->buf_len);
+    memset(out + 41 + ctx->buf_len, 0, 64 - ctx->buf_len);
+}
 
-    // 处理消息块
-    uint32_t V[8];
-    memcpy(V, IV, sizeof(IV));
+// 缓冲长度不小于64或与字节数不符时返回false，ctx不做修改
+bool SM3_Import(SM3_CTX* ctx, const uint8_t in[SM3_STATE_SIZE]) {
+    uint64_t total = 0;
+    for (int i = 0; i < 8; ++i) {
+        total = (total << 8) | in[32 + i];
+    }
+    size_t buf_len = in[40];
+    if (buf_len >= 64 || total % 64 != buf_len) {
+        return false;
+    }
 
-    for (size_t i = 0; i < pad_len; i += 64) {
-        Compression(V, &padded[i]);
+    for (int i = 0; i < 8; ++i) {
+        ctx->V[i] = ((uint32_t)in[i * 4] << 24) | (in[i * 4 + 1] << 16)
+            | (in[i * 4 + 2] << 8) | in[i * 4 + 3];
     }
+    ctx->total = total;
+    ctx->buf_len = buf_len;
+    memcpy(ctx->buf, in + 41, buf_len);
+    return true;
+}
 
-    // 生成摘要
-    std::vector<uint8_t> digest(32);
+// 从分组边界处的链接变量继续：cv是前total字节压缩后的状态，字节序与摘要相同。
+// total必须是64的倍数，否则返回false
+bool SM3_Resume(SM3_CTX* ctx, const uint8_t cv[32], uint64_t total) {
+    if (total % 64 != 0) {
+        return false;
+    }
     for (int i = 0; i < 8; ++i) {
-        digest[i * 4] = (V[i] >> 24) & 0xFF;
-        digest[i * 4 + 1] = (V[i] >> 16) & 0xFF;
-        digest[i * 4 + 2] = (V[i] >> 8) & 0xFF;
-        digest[i * 4 + 3] = V[i] & 0xFF;
+        ctx->V[i] = ((uint32_t)cv[i * 4] << 24) | (cv[i * 4 + 1] << 16)
+            | (cv[i * 4 + 2] << 8) | cv[i * 4 + 3];
+    }
+    ctx->total = total;
+    ctx->buf_len = 0;
+    return true;
+}
+
+// ====== 多缓冲SIMD版本 =====
+// 单条消息的压缩是严格串行的，SIMD无法加速；但大量独立的短消息（记录、叶子节点）
+// 可以每条占一个32位通道同时压缩：AVX2一次8条，AVX-512一次16条。寄存器V[i]的
+// 第k个通道是第k条消息的状态字i，消息按字转置后装入寄存器，消息扩展和64轮都在向量
+// 寄存器上完成。各内核用target属性编译，运行时按CPUID选择，不需要 -mavx2 等编译选项。
+
+// 各通道的分组来源：前nfull块直接读调用者内存，之后1~2块是tail中填充好的尾部，
+// 再往后（其他通道还没结束时）读全0块，结果被丢弃
+struct LaneState {
+    const uint8_t* msg;
+    size_t nfull, nblocks;
+    uint8_t tail[128];
+};
+
+static const uint8_t ZERO_BLOCK[64] = { 0 };
+
+// 填充各通道的尾部，返回最大块数
+static size_t SetupLanes(LaneState* lanes, const uint8_t* const* msgs, const size_t* lens, int n) {
+    size_t max_blocks = 0;
+    for (int k = 0; k < n; ++k) {
+        LaneState& l = lanes[k];
+        size_t rem = lens[k] % 64;
+        size_t ntail = rem < 56 ? 1 : 2;
+        l.msg = msgs[k];
+        l.nfull = lens[k] / 64;
+        l.nblocks = l.nfull + ntail;
+        memset(l.tail, 0, 64 * ntail);
+        if (rem > 0) {
+            memcpy(l.tail, msgs[k] + 64 * l.nfull, rem);
+        }
+        l.tail[rem] = 0x80;
+        uint64_t bit_len = (uint64_t)lens[k] * 8;
+        for (int i = 0; i < 8; ++i) {
+            l.tail[64 * ntail - 8 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+        }
+        max_blocks = std::max(max_blocks, l.nblocks);
+    }
+    return max_blocks;
+}
+
+static inline const uint8_t* LaneBlock(const LaneState& l, size_t b) {
+    return b < l.nfull ? l.msg + 64 * b : b < l.nblocks ? l.tail + 64 * (b - l.nfull) : ZERO_BLOCK;
+}
+
+// st[i * n + k]为第k条消息的状态字i
+static void StoreDigests(const uint32_t* st, int n, uint8_t (*digests)[32]) {
+    for (int k = 0; k < n; ++k) {
+        for (int i = 0; i < 8; ++i) {
+            uint32_t v = st[i * n + k];
+            digests[k][i * 4] = (v >> 24) & 0xFF;
+            digests[k][i * 4 + 1] = (v >> 16) & 0xFF;
+            digests[k][i * 4 + 2] = (v >> 8) & 0xFF;
+            digests[k][i * 4 + 3] = v & 0xFF;
+        }
     }
-    return digest;
 }
 
-// SIMD优化版本
-#ifdef __AVX2__
+// ------ AVX2：8路 ------
 
-inline __m256i _mm256_rotl_epi32(__m256i x, int n) {
+SM3_TARGET("avx2") inline __m256i _mm256_rotl_epi32(__m256i x, int n) {
     return _mm256_or_si256(_mm256_slli_epi32(x, n),
         _mm256_srli_epi32(x, 32 - n));
 }
 
-void Compression_SIMD(uint32_t V[8], const uint8_t block[64]) {
-    uint32_t W[68], W1[64];
-    MessageExpansion(block, W, W1);
+SM3_TARGET("avx2") inline __m256i P0_x8(__m256i x) {
+    return _mm256_xor_si256(_mm256_xor_si256(x, _mm256_rotl_epi32(x, 9)), _mm256_rotl_epi32(x, 17));
+}
+
+SM3_TARGET("avx2") inline __m256i P1_x8(__m256i x) {
+    return _mm256_xor_si256(_mm256_xor_si256(x, _mm256_rotl_epi32(x, 15)), _mm256_rotl_epi32(x, 23));
+}
+
+// 第16~63轮的布尔函数：FF为多数函数，GG为选择函数
+SM3_TARGET("avx2") inline __m256i FF1_x8(__m256i x, __m256i y, __m256i z) {
+    return _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(_mm256_or_si256(x, y), z));
+}
+
+SM3_TARGET("avx2") inline __m256i GG1_x8(__m256i x, __m256i y, __m256i z) {
+    return _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)));
+}
+
+// 一轮压缩，ff/gg为本轮的布尔函数值，t为ROTL(T[j], j % 32)
+SM3_TARGET("avx2") inline void Round_x8(__m256i& A, __m256i& B, __m256i& C, __m256i& D,
+    __m256i& E, __m256i& F, __m256i& G, __m256i& H,
+    __m256i ff, __m256i gg, __m256i Wj, __m256i Wj4, uint32_t t) {
+    __m256i A12 = _mm256_rotl_epi32(A, 12);
+    __m256i SS1 = _mm256_rotl_epi32(_mm256_add_epi32(_mm256_add_epi32(A12, E), _mm256_set1_epi32((int)t)), 7);
+    __m256i SS2 = _mm256_xor_si256(SS1, A12);
+    __m256i TT1 = _mm256_add_epi32(_mm256_add_epi32(ff, D), _mm256_add_epi32(SS2, _mm256_xor_si256(Wj, Wj4)));
+    __m256i TT2 = _mm256_add_epi32(_mm256_add_epi32(gg, H), _mm256_add_epi32(SS1, Wj));
+
+    D = C; C = _mm256_rotl_epi32(B, 9); B = A; A = TT1;
+    H = G; G = _mm256_rotl_epi32(F, 19); F = E; E = P0_x8(TT2);
+}
+
+// 8个分组的前16个字转置装入W：W[i]的第k个通道是blocks[k]的第i个字（按大端读取）
+SM3_TARGET("avx2") static void LoadTransposed_x8(const uint8_t* const blocks[8], __m256i W[16]) {
+    const __m256i bswap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (int h = 0; h < 2; ++h) {
+        __m256i r[8], t[8], u[8];
+        for (int k = 0; k < 8; ++k) {
+            r[k] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(blocks[k] + 32 * h)), bswap);
+        }
+        for (int k = 0; k < 8; k += 2) {
+            t[k] = _mm256_unpacklo_epi32(r[k], r[k + 1]);
+            t[k + 1] = _mm256_unpackhi_epi32(r[k], r[k + 1]);
+        }
+        for (int k = 0; k < 8; k += 4) {
+            u[k] = _mm256_unpacklo_epi64(t[k], t[k + 2]);
+            u[k + 1] = _mm256_unpackhi_epi64(t[k], t[k + 2]);
+            u[k + 2] = _mm256_unpacklo_epi64(t[k + 1], t[k + 3]);
+            u[k + 3] = _mm256_unpackhi_epi64(t[k + 1], t[k + 3]);
+        }
+        // u[0..3]是第0~3条消息的字(0,4)(1,5)(2,6)(3,7)，u[4..7]是第4~7条
+        for (int w = 0; w < 4; ++w) {
+            W[8 * h + w] = _mm256_permute2x128_si256(u[w], u[w + 4], 0x20);
+            W[8 * h + w + 4] = _mm256_permute2x128_si256(u[w], u[w + 4], 0x31);
+        }
+    }
+}
+
+// 8条消息各压缩一个分组
+SM3_TARGET("avx2") void Compression_SIMD(__m256i V[8], const uint8_t* const blocks[8]) {
+    __m256i W[68];
+    LoadTransposed_x8(blocks, W);
+    for (int i = 16; i < 68; ++i) {
+        W[i] = _mm256_xor_si256(_mm256_xor_si256(
+            P1_x8(_mm256_xor_si256(_mm256_xor_si256(W[i - 16], W[i - 9]), _mm256_rotl_epi32(W[i - 3], 15))),
+            _mm256_rotl_epi32(W[i - 13], 7)), W[i - 6]);
+    }
+
+    __m256i A = V[0], B = V[1], C = V[2], D = V[3];
+    __m256i E = V[4], F = V[5], G = V[6], H = V[7];
+
+    // 前16轮和后48轮只有布尔函数不同，分成两个循环，轮内没有分支
+    for (int j = 0; j < 16; ++j) {
+        Round_x8(A, B, C, D, E, F, G, H,
+            _mm256_xor_si256(_mm256_xor_si256(A, B), C), _mm256_xor_si256(_mm256_xor_si256(E, F), G),
+            W[j], W[j + 4], T_ROT.v[j]);
+    }
+    for (int j = 16; j < 64; ++j) {
+        Round_x8(A, B, C, D, E, F, G, H, FF1_x8(A, B, C), GG1_x8(E, F, G), W[j], W[j + 4], T_ROT.v[j]);
+    }
+
+    V[0] = _mm256_xor_si256(V[0], A); V[1] = _mm256_xor_si256(V[1], B);
+    V[2] = _mm256_xor_si256(V[2], C); V[3] = _mm256_xor_si256(V[3], D);
+    V[4] = _mm256_xor_si256(V[4], E); V[5] = _mm256_xor_si256(V[5], F);
+    V[6] = _mm256_xor_si256(V[6], G); V[7] = _mm256_xor_si256(V[7], H);
+}
+
+// 同时计算8条消息的摘要，长度可以不同
+SM3_TARGET("avx2") void SM3_x8(const uint8_t* const msgs[8], const size_t lens[8], uint8_t digests[8][32]) {
+    LaneState lanes[8];
+    size_t max_blocks = SetupLanes(lanes, msgs, lens, 8);
 
-    __m256i v_A = _mm256_set1_epi32(V[0]);
-    __m256i v_B = _mm256_set1_epi32(V[1]);
-    __m256i v_C = _mm256_set1_epi32(V[2]);
-    __m256i v_D = _mm256_set1_epi32(V[3]);
-    __m256i v_E = _mm256_set1_epi32(V[4]);
-    __m256i v_F = _mm256_set1_epi32(V[5]);
-    __m256i v_G = _mm256_set1_epi32(V[6]);
-    __m256i v_H = _mm256_set1_epi32(V[7]);
-
-    for (int j = 0; j < 64; j += 4) {
-        // 处理4轮并行
-        __m256i v_T = _mm256_set_epi32(T[j + 3], T[j + 2], T[j + 1], T[j], 0, 0, 0, 0);
-        __m256i v_W = _mm256_set_epi32(W[j + 3], W[j + 2], W[j + 1], W[j], 0, 0, 0, 0);
-        __m256i v_W1 = _mm256_set_epi32(W1[j + 3], W1[j + 2], W1[j + 1], W1[j], 0, 0, 0, 0);
-
-        __m256i v_SS1 = _mm256_rotl_epi32(
-            _mm256_add_epi32(
-                _mm256_rotl_epi32(v_A, 12),
-                _mm256_add_epi32(v_E, _mm256_rotl_epi32(v_T, j % 32))
-            ), 7);
-
-        __m256i v_SS2 = _mm256_xor_si256(v_SS1, _mm256_rotl_epi32(v_A, 12));
-
-        __m256i v_TT1 = _mm256_add_epi32(
-            _mm256_add_epi32(
-                _mm256_add_epi32(
-                    _mm256_set1_epi32(FF(V[0], V[1], V[2], j)),
-                    v_D),
-                _mm256_add_epi32(v_SS2, v_W1));
-
-        __m256i v_TT2 = _mm256_add_epi32(
-            _mm256_add_epi32(
-                _mm256_add_epi32(
-                    _mm256_set1_epi32(GG(V[4], V[5], V[6], j)),
-                    v_H),
-                _mm256_add_epi32(v_SS1, v_W));
-
-        v_D = v_C; v_C = _mm256_rotl_epi32(v_B, 9); v_B = v_A; v_A = v_TT1;
-        v_H = v_G; v_G = _mm256_rotl_epi32(v_F, 19); v_F = v_E;
-        v_E = _mm256_xor_si256(
-            _mm256_xor_si256(v_TT2, _mm256_rotl_epi32(v_TT2, 9)),
-            _mm256_rotl_epi32(v_TT2, 17));
-    }
-
-    alignas(32) uint32_t res[8];
-    _mm256_store_si256((__m256i*)res, v_A);
-    V[0] ^= res[0]; V[1] ^= res[1]; V[2] ^= res[2]; V[3] ^= res[3];
-    V[4] ^= res[4]; V[5] ^= res[5]; V[6] ^= res[6]; V[7] ^= res[7];
-}
-
-std::vector<uint8_t> SM3_SIMD(const uint8_t* msg, size_t len) {
-    // 消息填充（与基础版本相同）
-    uint64_t bit_len = len * 8;
-    size_t pad_len = ((len + 8 + 1 + 63) / 64) * 64;
-    std::vector<uint8_t> padded(pad_len, 0);
-    memcpy(padded.data(), msg, len);
-    padded[len] = 0x80;
+    __m256i V[8];
     for (int i = 0; i < 8; ++i) {
-        padded[pad_len - 8 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+        V[i] = _mm256_set1_epi32((int)IV[i]);
     }
 
-    uint32_t V[8];
-    memcpy(V, IV, sizeof(IV));
+    for (size_t b = 0; b < max_blocks; ++b) {
+        const uint8_t* blocks[8];
+        alignas(32) int32_t active[8];
+        bool all_active = true;
+        for (int k = 0; k < 8; ++k) {
+            blocks[k] = LaneBlock(lanes[k], b);
+            active[k] = b < lanes[k].nblocks ? -1 : 0;
+            all_active = all_active && b < lanes[k].nblocks;
+        }
 
-    for (size_t i = 0; i < pad_len; i += 64) {
-        Compression_SIMD(V, &padded[i]);
+        if (all_active) {
+            Compression_SIMD(V, blocks);
+        }
+        else {
+            __m256i old[8];
+            memcpy(old, V, sizeof(old));
+            Compression_SIMD(V, blocks);
+            __m256i mask = _mm256_load_si256((const __m256i*)active);
+            for (int i = 0; i < 8; ++i) {
+                V[i] = _mm256_blendv_epi8(old[i], V[i], mask);
+            }
+        }
     }
 
-    std::vector<uint8_t> digest(32);
+    alignas(32) uint32_t st[8 * 8];
     for (int i = 0; i < 8; ++i) {
-        digest[i * 4] = (V[i] >> 24) & 0xFF;
-        digest[i * 4 + 1] = (V[i] >> 16) & 0xFF;
-        digest[i * 4 + 2] = (V[i] >> 8) & 0xFF;
-        digest[i * 4 + 3] = V[i] & 0xFF;
+        _mm256_store_si256((__m256i*)&st[8 * i], V[i]);
     }
-    return digest;
+    StoreDigests(st, 8, digests);
+}
+
+// ------ AVX-512：16路 ------
+// 循环移位用vprold一条指令；三输入的布尔函数（异或、多数、选择）各用一条vpternlogd，
+// 立即数是三个输入取值表(0xF0, 0xCC, 0xAA)经过该函数的结果。只需要AVX-512F。
+
+#define TERN_XOR3 0x96   // x ^ y ^ z
+#define TERN_MAJ  0xE8   // (x & y) | (x & z) | (y & z)
+#define TERN_SEL  0xCA   // (x & y) | (~x & z)
+
+SM3_TARGET("avx512f") inline __m512i Xor3_x16(__m512i x, __m512i y, __m512i z) {
+    return _mm512_ternarylogic_epi32(x, y, z, TERN_XOR3);
+}
+
+SM3_TARGET("avx512f") inline __m512i P0_x16(__m512i x) {
+    return Xor3_x16(x, _mm512_rol_epi32(x, 9), _mm512_rol_epi32(x, 17));
+}
+
+SM3_TARGET("avx512f") inline __m512i P1_x16(__m512i x) {
+    return Xor3_x16(x, _mm512_rol_epi32(x, 15), _mm512_rol_epi32(x, 23));
+}
+
+// 字节序翻转：按字节选择 ROTL(x, 8) 和 ROTL(x, 24)，不需要AVX-512BW的vpshufb
+SM3_TARGET("avx512f") inline __m512i Bswap_x16(__m512i x) {
+    return _mm512_ternarylogic_epi32(_mm512_set1_epi32(0x00FF00FF),
+        _mm512_rol_epi32(x, 8), _mm512_rol_epi32(x, 24), TERN_SEL);
+}
+
+// 一轮压缩，TERN为本轮FF/GG对应的vpternlogd立即数
+template <int FF_IMM, int GG_IMM>
+SM3_TARGET("avx512f") inline void Round_x16(__m512i& A, __m512i& B, __m512i& C, __m512i& D,
+    __m512i& E, __m512i& F, __m512i& G, __m512i& H, __m512i Wj, __m512i Wj4, uint32_t t) {
+    __m512i A12 = _mm512_rol_epi32(A, 12);
+    __m512i SS1 = _mm512_rol_epi32(_mm512_add_epi32(_mm512_add_epi32(A12, E), _mm512_set1_epi32((int)t)), 7);
+    __m512i SS2 = _mm512_xor_si512(SS1, A12);
+    __m512i ff = _mm512_ternarylogic_epi32(A, B, C, FF_IMM);
+    __m512i gg = _mm512_ternarylogic_epi32(E, F, G, GG_IMM);
+    __m512i TT1 = _mm512_add_epi32(_mm512_add_epi32(ff, D), _mm512_add_epi32(SS2, _mm512_xor_si512(Wj, Wj4)));
+    __m512i TT2 = _mm512_add_epi32(_mm512_add_epi32(gg, H), _mm512_add_epi32(SS1, Wj));
+
+    D = C; C = _mm512_rol_epi32(B, 9); B = A; A = TT1;
+    H = G; G = _mm512_rol_epi32(F, 19); F = E; E = P0_x16(TT2);
+}
+
+// 16个分组转置装入W[0..15]（16x16的32位转置）
+SM3_TARGET("avx512f") static void LoadTransposed_x16(const uint8_t* const blocks[16], __m512i W[16]) {
+    __m512i r[16], t[16], u[16];
+    for (int k = 0; k < 16; ++k) {
+        r[k] = Bswap_x16(_mm512_loadu_si512((const void*)blocks[k]));
+    }
+    for (int k = 0; k < 16; k += 2) {
+        t[k] = _mm512_unpacklo_epi32(r[k], r[k + 1]);
+        t[k + 1] = _mm512_unpackhi_epi32(r[k], r[k + 1]);
+    }
+    for (int k = 0; k < 16; k += 4) {
+        u[k] = _mm512_unpacklo_epi64(t[k], t[k + 2]);
+        u[k + 1] = _mm512_unpackhi_epi64(t[k], t[k + 2]);
+        u[k + 2] = _mm512_unpacklo_epi64(t[k + 1], t[k + 3]);
+        u[k + 3] = _mm512_unpackhi_epi64(t[k + 1], t[k + 3]);
+    }
+    // u[4g+c]的第L个128位通道是第4g~4g+3条消息的字4L+c，再按128位通道重排
+    for (int c = 0; c < 4; ++c) {
+        __m512i a0 = _mm512_shuffle_i32x4(u[c], u[4 + c], 0x44);
+        __m512i b0 = _mm512_shuffle_i32x4(u[c], u[4 + c], 0xEE);
+        __m512i a1 = _mm512_shuffle_i32x4(u[8 + c], u[12 + c], 0x44);
+        __m512i b1 = _mm512_shuffle_i32x4(u[8 + c], u[12 + c], 0xEE);
+        W[c] = _mm512_shuffle_i32x4(a0, a1, 0x88);
+        W[4 + c] = _mm512_shuffle_i32x4(a0, a1, 0xDD);
+        W[8 + c] = _mm512_shuffle_i32x4(b0, b1, 0x88);
+        W[12 + c] = _mm512_shuffle_i32x4(b0, b1, 0xDD);
+    }
+}
+
+// 16条消息各压缩一个分组
+SM3_TARGET("avx512f") void Compression_AVX512(__m512i V[8], const uint8_t* const blocks[16]) {
+    __m512i W[68];
+    LoadTransposed_x16(blocks, W);
+    for (int i = 16; i < 68; ++i) {
+        __m512i x = Xor3_x16(W[i - 16], W[i - 9], _mm512_rol_epi32(W[i - 3], 15));
+        W[i] = Xor3_x16(P1_x16(x), _mm512_rol_epi32(W[i - 13], 7), W[i - 6]);
+    }
+
+    __m512i A = V[0], B = V[1], C = V[2], D = V[3];
+    __m512i E = V[4], F = V[5], G = V[6], H = V[7];
+
+    for (int j = 0; j < 16; ++j) {
+        Round_x16<TERN_XOR3, TERN_XOR3>(A, B, C, D, E, F, G, H, W[j], W[j + 4], T_ROT.v[j]);
+    }
+    for (int j = 16; j < 64; ++j) {
+        Round_x16<TERN_MAJ, TERN_SEL>(A, B, C, D, E, F, G, H, W[j], W[j + 4], T_ROT.v[j]);
+    }
+
+    V[0] = _mm512_xor_si512(V[0], A); V[1] = _mm512_xor_si512(V[1], B);
+    V[2] = _mm512_xor_si512(V[2], C); V[3] = _mm512_xor_si512(V[3], D);
+    V[4] = _mm512_xor_si512(V[4], E); V[5] = _mm512_xor_si512(V[5], F);
+    V[6] = _mm512_xor_si512(V[6], G); V[7] = _mm512_xor_si512(V[7], H);
 }
+
+// 同时计算16条消息的摘要，长度可以不同
+SM3_TARGET("avx512f") void SM3_x16(const uint8_t* const msgs[16], const size_t lens[16], uint8_t digests[16][32]) {
+    LaneState lanes[16];
+    size_t max_blocks = SetupLanes(lanes, msgs, lens, 16);
+
+    __m512i V[8];
+    for (int i = 0; i < 8; ++i) {
+        V[i] = _mm512_set1_epi32((int)IV[i]);
+    }
+
+    for (size_t b = 0; b < max_blocks; ++b) {
+        const uint8_t* blocks[16];
+        __mmask16 active = 0;
+        for (int k = 0; k < 16; ++k) {
+            blocks[k] = LaneBlock(lanes[k], b);
+            if (b < lanes[k].nblocks) active |= (__mmask16)(1u << k);
+        }
+
+        if (active == 0xFFFF) {
+            Compression_AVX512(V, blocks);
+        }
+        else {
+            __m512i old[8];
+            memcpy(old, V, sizeof(old));
+            Compression_AVX512(V, blocks);
+            for (int i = 0; i < 8; ++i) {
+                V[i] = _mm512_mask_mov_epi32(old[i], active, V[i]);
+            }
+        }
+    }
+
+    alignas(64) uint32_t st[8 * 16];
+    for (int i = 0; i < 8; ++i) {
+        _mm512_store_si512((void*)&st[16 * i], V[i]);
+    }
+    StoreDigests(st, 16, digests);
+}
+
+// ------ 运行时选择 ------
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t r[4]) {
+#if defined(_MSC_VER)
+    int t[4];
+    __cpuidex(t, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) r[i] = (uint32_t)t[i];
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &r[0], &r[1], &r[2], &r[3])) {
+        r[0] = r[1] = r[2] = r[3] = 0;
+    }
 #endif
+}
+
+// 读取XCR0，确认操作系统会保存YMM/ZMM寄存器
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+// CPU支持的最大通道数：16（AVX-512F）、8（AVX2）或1（只有标量）
+static int DetectLanes() {
+    uint32_t r0[4], r1[4], r7[4] = { 0 };
+    cpuid(0, 0, r0);
+    cpuid(1, 0, r1);
+    if (r0[0] >= 7) {
+        cpuid(7, 0, r7);
+    }
+    int osxsave = (r1[2] >> 27) & 1;
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    bool avx2 = (xcr0 & 0x6) == 0x6 && ((r1[2] >> 28) & 1) && ((r7[1] >> 5) & 1);
+    bool avx512 = avx2 && (xcr0 & 0xE6) == 0xE6 && ((r7[1] >> 16) & 1);
+    return avx512 ? 16 : avx2 ? 8 : 1;
+}
+
+static const int max_lanes = DetectLanes();
+static int simd_lanes = max_lanes;
+
+int SM3_simd_lanes() {
+    return simd_lanes;
+}
+
+// 强制使用8路/16路/标量（1），CPU不支持时返回false且不做修改
+bool SM3_set_simd_lanes(int lanes) {
+    if ((lanes != 1 && lanes != 8 && lanes != 16) || lanes > max_lanes) {
+        return false;
+    }
+    simd_lanes = lanes;
+    return true;
+}
+
+// 计算n条独立消息的摘要：按当前的通道数分组，最后不满的一组用空消息补齐通道
+// （剩余不超过8条时用8路），只剩1条时直接用标量版本
+void SM3_multi(const uint8_t* const* msgs, const size_t* lens, size_t n, uint8_t (*digests)[32]) {
+    size_t i = 0;
+    while (simd_lanes > 1 && n - i >= 2) {
+        size_t lanes = simd_lanes == 16 && n - i > 8 ? 16 : 8;
+        size_t cnt = std::min(n - i, lanes);
+        const uint8_t* m[16];
+        size_t l[16];
+        uint8_t d[16][32];
+        for (size_t k = 0; k < lanes; ++k) {
+            m[k] = k < cnt ? msgs[i + k] : msgs[i];
+            l[k] = k < cnt ? lens[i + k] : 0;
+        }
+        if (lanes == 16) {
+            SM3_x16(m, l, d);
+        }
+        else {
+            SM3_x8(m, l, d);
+        }
+        memcpy(digests + i, d, 32 * cnt);
+        i += cnt;
+    }
+    for (; i < n; ++i) {
+        auto d = SM3(msgs[i], lens[i]);
+        memcpy(digests[i], d.data(), 32);
+    }
+}
 
 // 测试验证
 void test_vectors() {
@@ -215,7 +750,7 @@ void test_vectors() {
         std::string hex;
         for (auto b : digest) {
             char buf[3];
-            sprintf_s(buf, sizeof(buf), "%02x", b);
+            snprintf(buf, sizeof(buf), "%02x", b);
             hex += buf;
         }
 
@@ -227,34 +762,217 @@ void test_vectors() {
     std::cout << "All tests passed!\n";
 }
 
+// 优化的压缩函数与参考实现比较，随机状态和分组
+void test_compression() {
+    for (int trial = 0; trial < 1000; ++trial) {
+        uint32_t V[8], V_ref[8];
+        uint8_t block[64];
+        for (auto& v : V) v = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        for (auto& b : block) b = rand() % 256;
+        memcpy(V_ref, V, sizeof(V));
+        Compression(V, block);
+        Compression_Ref(V_ref, block);
+        assert(memcmp(V, V_ref, sizeof(V)) == 0 && "Compression mismatch");
+    }
+    std::cout << "Compression tests passed!\n";
+}
+
+// 流式接口按随机长度分段输入，结果与一次性计算相同
+void test_streaming() {
+    std::vector<uint8_t> data(1000);
+    for (auto& b : data) b = rand() % 256;
+
+    for (size_t len : { (size_t)0, (size_t)55, (size_t)56, (size_t)64, (size_t)119, (size_t)1000 }) {
+        auto expected = SM3(data.data(), len);
+        for (int trial = 0; trial < 20; ++trial) {
+            SM3_CTX ctx;
+            SM3_Init(&ctx);
+            for (size_t off = 0; off < len;) {
+                size_t n = std::min(len - off, (size_t)(rand() % 150));
+                SM3_Update(&ctx, data.data() + off, n);
+                off += n;
+            }
+            uint8_t digest[32];
+            SM3_Final(&ctx, digest);
+            assert(memcmp(digest, expected.data(), 32) == 0 && "Streaming mismatch");
+        }
+    }
+    std::cout << "Streaming tests passed!\n";
+}
+
+// 从中间状态继续（直接复制、Export/Import、Resume）与完整计算相同
+void test_midstate() {
+    std::vector<uint8_t> data(300);
+    for (auto& b : data) b = rand() % 256;
+
+    for (size_t prefix : { (size_t)0, (size_t)13, (size_t)64, (size_t)100, (size_t)128 }) {
+        SM3_CTX base;
+        SM3_Init(&base);
+        SM3_Update(&base, data.data(), prefix);
+
+        uint8_t state[SM3_STATE_SIZE];
+        SM3_Export(&base, state);
+        SM3_CTX imported;
+        assert(SM3_Import(&imported, state) && "Import rejected a valid state");
+
+        for (size_t len = prefix; len <= data.size(); len += 37) {
+            auto expected = SM3(data.data(), len);
+            uint8_t digest[32];
+
+            SM3_CTX ctx = base;
+            SM3_Update(&ctx, data.data() + prefix, len - prefix);
+            SM3_Final(&ctx, digest);
+            assert(memcmp(digest, expected.data(), 32) == 0 && "Midstate copy mismatch");
+
+            ctx = imported;
+            SM3_Update(&ctx, data.data() + prefix, len - prefix);
+            SM3_Final(&ctx, digest);
+            assert(memcmp(digest, expected.data(), 32) == 0 && "Midstate import mismatch");
+
+            if (prefix % 64 == 0) {
+                assert(SM3_Resume(&ctx, state, prefix));
+                SM3_Update(&ctx, data.data() + prefix, len - prefix);
+                SM3_Final(&ctx, digest);
+                assert(memcmp(digest, expected.data(), 32) == 0 && "Midstate resume mismatch");
+            }
+        }
+    }
+
+    // 不合法的状态
+    SM3_CTX ctx;
+    SM3_Init(&ctx);
+    SM3_Update(&ctx, data.data(), 10);
+    uint8_t state[SM3_STATE_SIZE];
+    SM3_Export(&ctx, state);
+    state[40] = 64;
+    assert(!SM3_Import(&ctx, state));
+    state[40] = 11;
+    assert(!SM3_Import(&ctx, state));
+    assert(!SM3_Resume(&ctx, state, 10));
+    std::cout << "Midstate tests passed!\n";
+}
+
+// 多缓冲版本与逐条计算比较，长度覆盖填充为1块和2块、各通道块数不同、最后一组不满的情况；
+// CPU支持的每种通道数都测一遍
+void test_multi_buffer() {
+    const size_t N = 45;
+    std::vector<std::vector<uint8_t>> msgs(N);
+    std::vector<const uint8_t*> ptrs(N);
+    std::vector<size_t> lens(N);
+    for (size_t i = 0; i < N; ++i) {
+        msgs[i].resize(i * 7);
+        for (auto& b : msgs[i]) b = rand() % 256;
+        ptrs[i] = msgs[i].data();
+        lens[i] = msgs[i].size();
+    }
+
+    int selected = SM3_simd_lanes();
+    for (int lanes : { 16, 8 }) {
+        if (!SM3_set_simd_lanes(lanes)) continue;
+        std::vector<uint8_t> digests(N * 32);
+        SM3_multi(ptrs.data(), lens.data(), N, (uint8_t (*)[32])digests.data());
+        for (size_t i = 0; i < N; ++i) {
+            auto expected = SM3(ptrs[i], lens[i]);
+            assert(memcmp(expected.data(), &digests[i * 32], 32) == 0 && "Multi-buffer mismatch");
+        }
+        std::cout << "Multi-buffer x" << lanes << " tests passed!\n";
+    }
+    SM3_set_simd_lanes(selected);
+}
+
 // 性能对比
 void benchmark() {
     const size_t SIZE = 1 << 24; // 16MB数据
     std::vector<uint8_t> data(SIZE);
     for (auto& b : data) b = rand() % 256;
 
-    // 基础版本
+    // 单条长消息
     auto start = std::chrono::high_resolution_clock::now();
     auto hash = SM3(data.data(), data.size());
     auto end = std::chrono::high_resolution_clock::now();
-    auto baseline_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    auto baseline_time = std::chrono::duration<double, std::milli>(end - start).count();
 
-    // SIMD版本
-#ifdef __AVX2__
+    // 同样的数据用参考压缩函数逐块计算（不含填充）
+    uint32_t V[8];
+    memcpy(V, IV, sizeof(IV));
     start = std::chrono::high_resolution_clock::now();
-    auto hash_simd = SM3_SIMD(data.data(), data.size());
+    for (size_t i = 0; i < SIZE; i += 64) {
+        Compression_Ref(V, &data[i]);
+    }
     end = std::chrono::high_resolution_clock::now();
-    auto simd_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-
-    assert(hash == hash_simd && "Hash mismatch between versions");
-#endif
+    auto reference_time = std::chrono::duration<double, std::milli>(end - start).count();
+    volatile uint32_t sink = V[0];  // 防止被优化掉
+    (void)sink;
 
+    std::cout << std::fixed << std::setprecision(1);
     std::cout << "\nPerformance Results (16MB data):\n";
-    std::cout << "  Baseline: " << baseline_time << "ms\n";
-#ifdef __AVX2__
-    std::cout << "  SIMD:     " << simd_time << "ms ("
-        << (baseline_time * 100 / simd_time) << "% of baseline)\n";
-#endif
+    std::cout << "  Single message: " << baseline_time << "ms (reference compression: "
+        << reference_time << "ms)\n";
+
+    // 同样的数据切成64字节的独立记录
+    const size_t RECORD = 64, N = SIZE / RECORD;
+    std::vector<const uint8_t*> ptrs(N);
+    std::vector<size_t> lens(N, RECORD);
+    for (size_t i = 0; i < N; ++i) ptrs[i] = &data[i * RECORD];
+    std::vector<uint8_t> digests(N * 32), digests_multi(N * 32);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < N; ++i) {
+        auto d = SM3(ptrs[i], lens[i]);
+        memcpy(&digests[i * 32], d.data(), 32);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto records_time = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << "  " << N << " x " << RECORD << "B records:\n";
+    std::cout << "    Scalar:       " << records_time << "ms\n";
+
+    int selected = SM3_simd_lanes();
+    for (int lanes : { 8, 16 }) {
+        if (!SM3_set_simd_lanes(lanes)) continue;
+        start = std::chrono::high_resolution_clock::now();
+        SM3_multi(ptrs.data(), lens.data(), N, (uint8_t (*)[32])digests_multi.data());
+        end = std::chrono::high_resolution_clock::now();
+        auto multi_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+        assert(digests == digests_multi && "Hash mismatch between versions");
+        std::cout << "    " << (lanes == 16 ? "AVX-512 x16:  " : "AVX2 x8:      ") << multi_time << "ms ("
+            << records_time / multi_time << "x)\n";
+    }
+    SM3_set_simd_lanes(selected);
+
+    // 共享128字节前缀的短消息：每条完整计算 vs 从缓存的中间状态继续
+    const size_t PREFIX = 128, M = 1 << 18;
+    SM3_CTX base;
+    SM3_Init(&base);
+    SM3_Update(&base, data.data(), PREFIX);
+    std::vector<uint8_t> msg(PREFIX + RECORD);
+    memcpy(msg.data(), data.data(), PREFIX);
+    uint8_t d_full[32], d_mid[32];
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < M; ++i) {
+        memcpy(&msg[PREFIX], &data[(i % N) * RECORD], RECORD);
+        SM3_CTX ctx;
+        SM3_Init(&ctx);
+        SM3_Update(&ctx, msg.data(), msg.size());
+        SM3_Final(&ctx, d_full);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto full_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < M; ++i) {
+        SM3_CTX ctx = base;
+        SM3_Update(&ctx, &data[(i % N) * RECORD], RECORD);
+        SM3_Final(&ctx, d_mid);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto midstate_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+    assert(memcmp(d_full, d_mid, 32) == 0 && "Midstate mismatch");
+    std::cout << "  " << M << " x (" << PREFIX << "B prefix + " << RECORD << "B):\n";
+    std::cout << "    Full:         " << full_time << "ms\n";
+    std::cout << "    Midstate:     " << midstate_time << "ms (" << full_time / midstate_time << "x)\n";
 }
 
 int main() {
@@ -262,6 +980,10 @@ int main() {
     std::cout << "================================\n";
 
     test_vectors();
+    test_compression();
+    test_streaming();
+    test_midstate();
+    test_multi_buffer();
     benchmark();
 
     // 示例用法